@@ -0,0 +1,93 @@
+#include "alloc_tracker.h"
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+using namespace std;
+
+#ifdef ALLOC_TRACKING
+
+// shared by every thread, so allocations made by pool workers count towards the stage that woke them
+static atomic<uint64_t> total_allocs(0), total_bytes(0), total_frees(0);
+
+static void *tracked_alloc(size_t size) {
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p != NULL) {
+        total_allocs.fetch_add(1, memory_order_relaxed);
+        total_bytes.fetch_add(size, memory_order_relaxed);
+    }
+    return p;
+}
+
+static void tracked_free(void *p) {
+    if (p == NULL) return;
+    total_frees.fetch_add(1, memory_order_relaxed);
+    free(p);
+}
+
+void *operator new(size_t size) {
+    void *p = tracked_alloc(size);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size) {
+    void *p = tracked_alloc(size);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return tracked_alloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return tracked_alloc(size);
+}
+
+void operator delete(void *p) noexcept {
+    tracked_free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    tracked_free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+    tracked_free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+    tracked_free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    tracked_free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    tracked_free(p);
+}
+
+bool alloc_tracking_enabled() {
+    return true;
+}
+
+AllocCounters alloc_counters() {
+    AllocCounters counters = {total_allocs.load(memory_order_relaxed), total_bytes.load(memory_order_relaxed),
+                              total_frees.load(memory_order_relaxed)};
+    return counters;
+}
+
+#else
+
+bool alloc_tracking_enabled() {
+    return false;
+}
+
+AllocCounters alloc_counters() {
+    AllocCounters none = {0, 0, 0};
+    return none;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+#include <stdint.h>
+
+/*
+ * Opt-in heap allocation accounting. When built with ALLOC_TRACKING
+ * (cmake -DALLOC_TRACKING=ON) the global operator new/delete are replaced by
+ * versions that count allocations and requested bytes across all threads; the
+ * profiler turns those running totals into per-stage and per-frame figures. The
+ * pool workers only run while a stage waits for them, so their allocations are
+ * counted in that stage.
+ * Without ALLOC_TRACKING the counters stay at zero and nothing is hooked.
+ */
+
+struct AllocCounters {
+    uint64_t allocs;
+    uint64_t bytes;
+    uint64_t frees;
+};
+
+bool alloc_tracking_enabled();
+
+// running totals for the whole process
+AllocCounters alloc_counters();
+
+#endif
@@ -0,0 +1,152 @@
+#include "collision_checker.h"
+#include <algorithm>
+#include <math.h>
+
+static void state_kernel(const float * __restrict c, float t, int n, float * __restrict s_out, float * __restrict d_out,
+                         float * __restrict s_dot, float * __restrict d_dot) {
+    for (int i = 0; i < n; i++) {
+        const float *r = c + i;
+        s_out[i] = ((((r[5*n]*t + r[4*n])*t + r[3*n])*t + r[2*n])*t + r[n])*t + r[0];
+        d_out[i] = ((((r[11*n]*t + r[10*n])*t + r[9*n])*t + r[8*n])*t + r[7*n])*t + r[6*n];
+        s_dot[i] = (((5*r[5*n]*t + 4*r[4*n])*t + 3*r[3*n])*t + 2*r[2*n])*t + r[n];
+        d_dot[i] = (((5*r[11*n]*t + 4*r[10*n])*t + 3*r[9*n])*t + 2*r[8*n])*t + r[7*n];
+    }
+}
+
+static int broad_kernel(const float * __restrict x, const float * __restrict y, int n, float cx, float cy, float reach2) {
+    int hits = 0;
+    for (int j = 0; j < n; j++) {
+        float dx = x[j] - cx;
+        float dy = y[j] - cy;
+        hits += dx*dx + dy*dy < reach2;
+    }
+    return hits;
+}
+
+static int narrow_kernel(const float * __restrict x, const float * __restrict y, const float * __restrict hx,
+                         const float * __restrict hy, int n, const float * __restrict offsets,
+                         const float * __restrict ego_x, const float * __restrict ego_y, float touch2) {
+    int hits = 0;
+    for (int j = 0; j < n; j++) {
+        for (int c = 0; c < FOOTPRINT_CIRCLES; c++) {
+            float cx = x[j] + offsets[c]*hx[j];
+            float cy = y[j] + offsets[c]*hy[j];
+            for (int e = 0; e < FOOTPRINT_CIRCLES; e++) {
+                float dx = cx - ego_x[e];
+                float dy = cy - ego_y[e];
+                hits += dx*dx + dy*dy < touch2;
+            }
+        }
+    }
+    return hits;
+}
+
+static int gather_kernel(const float * __restrict x, const float * __restrict y, const float * __restrict hx,
+                         const float * __restrict hy, int n, float x_min, float x_max, float y_min, float y_max,
+                         float * __restrict near_x, float * __restrict near_y, float * __restrict near_hx,
+                         float * __restrict near_hy) {
+    // every vehicle is written, and kept by advancing past it only if its center is in the box
+    int near = 0;
+    for (int j = 0; j < n; j++) {
+        near_x[near] = x[j];
+        near_y[near] = y[j];
+        near_hx[near] = hx[j];
+        near_hy[near] = hy[j];
+        near += x[j] >= x_min && x[j] <= x_max && y[j] >= y_min && y[j] <= y_max;
+    }
+    return near;
+}
+
+CollisionChecker::CollisionChecker() {}
+
+CollisionChecker::~CollisionChecker() {}
+
+int CollisionChecker::count_collisions() const {
+    int count = 0;
+    for (int i = 0; i < size(); i++) count += this->collides[i];
+    return count;
+}
+
+void CollisionChecker::reserve(int rows) {
+    this->near_x.reserve(rows);
+    this->near_y.reserve(rows);
+    this->near_heading_x.reserve(rows);
+    this->near_heading_y.reserve(rows);
+}
+
+void CollisionChecker::check(const TrajectorySet &set, const FrenetMap &frenet, const FootprintTable &traffic) {
+    /*
+    Step by step, all candidates still running are placed in one batch, and the vehicles within
+    reach of the box around them are gathered into short columns. Each such candidate is then
+    checked against those columns only, and drops out at its first contact.
+    */
+    int n = set.size();
+    int steps = traffic.steps();
+    this->collides.assign(n, 0);
+    this->contact_time.assign(n, -1);
+    this->x.resize(n);
+    this->y.resize(n);
+    this->heading_x.resize(n);
+    this->heading_y.resize(n);
+    this->s.resize(n);
+    this->d.resize(n);
+    this->s_dot.resize(n);
+    this->d_dot.resize(n);
+    this->near_x.resize(traffic.size());
+    this->near_y.resize(traffic.size());
+    this->near_heading_x.resize(traffic.size());
+    this->near_heading_y.resize(traffic.size());
+    if (traffic.size() == 0) return;
+
+    float offsets[FOOTPRINT_CIRCLES], ego_offsets[FOOTPRINT_CIRCLES];
+    for (int c = 0; c < FOOTPRINT_CIRCLES; c++) {
+        offsets[c] = traffic.footprint.offset(c);
+        ego_offsets[c] = this->footprint.offset(c);
+    }
+    float reach = this->footprint.reach() + traffic.footprint.reach();
+    float touch = this->footprint.radius() + traffic.footprint.radius();
+    // the quintics as float columns, s then d, lowest order first
+    this->coef.resize(2*QUINTIC_COEFFS*n);
+    for (int k = 0; k < QUINTIC_COEFFS; k++) {
+        for (int i = 0; i < n; i++) {
+            this->coef[k*n + i] = set.s_coef[k][i];
+            this->coef[(QUINTIC_COEFFS + k)*n + i] = set.d_coef[k][i];
+        }
+    }
+    for (int k = 0; k < steps; k++) {
+        float t = k*traffic.time_step;
+        state_kernel(this->coef.data(), t, n, this->s.data(), this->d.data(), this->s_dot.data(), this->d_dot.data());
+        frenet.to_cartesian(this->s.data(), this->d.data(), this->s_dot.data(), this->d_dot.data(), n,
+                            this->x.data(), this->y.data(), this->heading_x.data(), this->heading_y.data());
+        float x_min = INFINITY, x_max = -INFINITY, y_min = INFINITY, y_max = -INFINITY;
+        int running = 0;
+        for (int i = 0; i < n; i++) {
+            if (this->collides[i] || t > set.T[i]) continue;
+            running++;
+            x_min = min(x_min, this->x[i]);
+            x_max = max(x_max, this->x[i]);
+            y_min = min(y_min, this->y[i]);
+            y_max = max(y_max, this->y[i]);
+        }
+        if (running == 0) break;
+        int near = gather_kernel(traffic.x(k), traffic.y(k), traffic.heading_x(k), traffic.heading_y(k), traffic.size(),
+                                 x_min - reach, x_max + reach, y_min - reach, y_max + reach,
+                                 this->near_x.data(), this->near_y.data(), this->near_heading_x.data(),
+                                 this->near_heading_y.data());
+        if (near == 0) continue;
+        for (int i = 0; i < n; i++) {
+            if (this->collides[i] || t > set.T[i]) continue;
+            if (broad_kernel(this->near_x.data(), this->near_y.data(), near, this->x[i], this->y[i], reach*reach) == 0) continue;
+            float ego_x[FOOTPRINT_CIRCLES], ego_y[FOOTPRINT_CIRCLES];
+            for (int e = 0; e < FOOTPRINT_CIRCLES; e++) {
+                ego_x[e] = this->x[i] + ego_offsets[e]*this->heading_x[i];
+                ego_y[e] = this->y[i] + ego_offsets[e]*this->heading_y[i];
+            }
+            if (narrow_kernel(this->near_x.data(), this->near_y.data(), this->near_heading_x.data(),
+                              this->near_heading_y.data(), near, offsets, ego_x, ego_y, touch*touch) > 0) {
+                this->collides[i] = 1;
+                this->contact_time[i] = t;
+            }
+        }
+    }
+}
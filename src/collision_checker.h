@@ -0,0 +1,59 @@
+#ifndef COLLISION_CHECKER_H
+#define COLLISION_CHECKER_H
+#include <stdint.h>
+#include <vector>
+#include "footprint_table.h"
+#include "frenet_map.h"
+#include "trajectory_set.h"
+
+using namespace std;
+
+/*
+ * Batch collision check of candidate trajectories against the footprints of the
+ * predicted traffic, in Cartesian space. The candidates are stepped along their
+ * quintics at the table's time steps until they end or first touch a vehicle.
+ * At each step only the vehicles near the box around the running candidates are
+ * looked at; for each candidate a broad pass over them compares the distance
+ * between centers with the sum of both reaches, and only a candidate with a
+ * vehicle in reach compares every pair of circles. Both passes run across
+ * vehicles, so the compiler vectorizes them over contiguous columns.
+ */
+class CollisionChecker {
+public:
+
+    Footprint footprint; // of the ego
+
+    // results of the last check, one row per candidate
+    vector<uint8_t> collides;
+    vector<float> contact_time; // first time the footprints touch, -1 if they never do
+
+    /**
+    * Constructor
+    */
+    CollisionChecker();
+
+    /**
+    * Destructor
+    */
+    virtual ~CollisionChecker();
+
+    int size() const { return this->collides.size(); }
+
+    int count_collisions() const;
+
+    // makes room for rows vehicles
+    void reserve(int rows);
+
+    // checks every row of set over [0, T] against traffic, both placed on frenet
+    void check(const TrajectorySet &set, const FrenetMap &frenet, const FootprintTable &traffic);
+
+private:
+
+    vector<float> coef; // quintics of the rows being checked, column-major
+    // scratch of one step: the candidates, and the vehicles near any of them
+    vector<float> s, d, s_dot, d_dot;
+    vector<float> x, y, heading_x, heading_y;
+    vector<float> near_x, near_y, near_heading_x, near_heading_y;
+};
+
+#endif
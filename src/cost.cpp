@@ -1,13 +1,12 @@
 #include "cost.h"
 #include "vehicle.h"
-#include <functional>
+#include "prediction_store.h"
 #include <iterator>
 #include <map>
 #include <math.h>
+#include <stdlib.h>
 
-const float REACH_GOAL = 1;
-const float SAFETY=0.01;
-const float COMFORT=1;
+const float COLLISION_MARGIN=5; // m of s kept clear ahead of and behind the end state
 
 
 float goal_distance_cost(const Vehicle & vehicle, float dist) {
@@ -25,14 +24,14 @@ float goal_distance_cost(const Vehicle & vehicle, float dist) {
     return cost;
 }
 
-float safety_cost(const Vehicle & vehicle, float dist) {
+float safety_cost(const Vehicle & vehicle) {
     /*
     Cost becomes higher for trajectories with intended lane and final lane that have traffic slower than vehicle's target speed.
     */
 
     float cost;
     float delta = vehicle.target_speed-vehicle.v_s;
-    if (delta > 0) {
+    if (delta >= 0) {
         cost = 1 - exp(-delta);
     } else {
         cost = 100000;
@@ -40,35 +39,29 @@ float safety_cost(const Vehicle & vehicle, float dist) {
     return cost;
 }
 
-float comfort_cost(const Vehicle & vehicle, float dist) {
+float comfort_cost(const Vehicle & vehicle) {
     /*
     Cost becomes higher for trajectories with intended lane and final lane that have traffic slower than vehicle's target speed.
     */
 
     float cost=0;
-    if(vehicle.state.compare("LCR")==0||vehicle.state.compare("LCL")==0) cost=1;
+    // one per lane crossed; preparing a change keeps the lane
+    if(vehicle.state!=State::PLCL&&vehicle.state!=State::PLCR) cost=abs(lane_direction(vehicle.state));
     return cost;
 }
 
-float calculate_cost(const vector<Vehicle> & trajectory,float dist) {
+float collision_cost(const Vehicle & vehicle, const PredictionStore &predictions, float time_window) {
     /*
-    Sum weighted cost functions to get total cost for trajectory.
+    Expected number of vehicles within COLLISION_MARGIN of the trajectory's end state when the ego
+    gets there, over the weighted maneuver hypotheses of the traffic.
     */
-	Vehicle v_new=trajectory[1];
-
-    float cost = 0.0;
-
-    //Add additional cost functions here.
-    vector< function<float(const Vehicle &, float dist)>> cf_list = {goal_distance_cost, safety_cost,comfort_cost};
-    vector<float> weight_list = {REACH_GOAL, SAFETY,COMFORT};
-
-    for (int i = 0; i < cf_list.size(); i++) {
-        float new_cost = weight_list[i]*cf_list[i](v_new,dist);
-        cost += new_cost;
-    }
-
-    return cost;
-
+    return predictions.occupancy().mass(vehicle.lane, vehicle.s-COLLISION_MARGIN, vehicle.s+COLLISION_MARGIN, time_window);
 }
 
-
+float calculate_cost(const frame_vector<Vehicle> & trajectory,float dist, const PredictionStore &predictions, float time_window) {
+    /*
+    Sum weighted cost functions to get total cost for trajectory.
+    */
+    CostContext context = {dist, predictions, time_window};
+    return BehaviorCost::cost(trajectory[1], context);
+}
@@ -1,15 +1,57 @@
 #ifndef COST_H
 #define COST_H
 #include "vehicle.h"
+#include "cost_pipeline.h"
 
 using namespace std;
 
-float calculate_cost(const vector<Vehicle> & trajectory, float dist);
+class PredictionStore;
+
+constexpr float REACH_GOAL = 1;
+constexpr float SAFETY=0.01;
+constexpr float COMFORT=1;
+constexpr float COLLISION=50;
+
+float calculate_cost(const frame_vector<Vehicle> & trajectory, float dist, const PredictionStore &predictions, float time_window);
 
 float goal_distance_cost(const Vehicle & vehicle, float dist);
 
-float safety_cost(const Vehicle & vehicle, float dist);
+float safety_cost(const Vehicle & vehicle);
+
+float comfort_cost(const Vehicle & vehicle);
+
+float collision_cost(const Vehicle & vehicle, const PredictionStore &predictions, float time_window);
+
+// what the cost terms of a trajectory's end state are measured against
+struct CostContext {
+    float dist; // s of the goal
+    const PredictionStore &predictions;
+    float time_window;
+};
+
+struct GoalDistanceTerm {
+    static constexpr float weight = REACH_GOAL;
+    static float eval(const Vehicle &vehicle, const CostContext &context) { return goal_distance_cost(vehicle, context.dist); }
+};
+
+struct SafetyTerm {
+    static constexpr float weight = SAFETY;
+    static float eval(const Vehicle &vehicle, const CostContext &) { return safety_cost(vehicle); }
+};
+
+struct ComfortTerm {
+    static constexpr float weight = COMFORT;
+    static float eval(const Vehicle &vehicle, const CostContext &) { return comfort_cost(vehicle); }
+};
+
+struct CollisionTerm {
+    static constexpr float weight = COLLISION;
+    static float eval(const Vehicle &vehicle, const CostContext &context) {
+        return collision_cost(vehicle, context.predictions, context.time_window);
+    }
+};
 
-float comfort_cost(const Vehicle & vehicle, float dist);
+// cost of a behavior trajectory's end state; add terms here
+typedef CostPipeline<GoalDistanceTerm, SafetyTerm, ComfortTerm, CollisionTerm> BehaviorCost;
 
 #endif
@@ -0,0 +1,47 @@
+#ifndef COST_PIPELINE_H
+#define COST_PIPELINE_H
+
+/*
+ * Weighted sum of cost terms, composed at compile time. Every term is a type with
+ *
+ *     static constexpr float weight;
+ *     static float eval(const Subject &subject, const Context &context);
+ *
+ * and CostPipeline<A, B, C>::cost(subject, context) expands to
+ *
+ *     0 + A::weight*A::eval(...) + B::weight*B::eval(...) + C::weight*C::eval(...)
+ *
+ * summed left to right, with every call visible to the compiler: no type erasure
+ * and no containers. batch() costs n subjects in one loop.
+ */
+template <class... Terms>
+struct CostPipeline;
+
+template <>
+struct CostPipeline<> {
+    static const int size = 0;
+
+    template <class Subject, class Context>
+    static float add(float cost, const Subject &, const Context &) { return cost; }
+};
+
+template <class Term, class... Rest>
+struct CostPipeline<Term, Rest...> {
+    static const int size = 1 + sizeof...(Rest);
+
+    // cost plus the weighted terms
+    template <class Subject, class Context>
+    static float add(float cost, const Subject &subject, const Context &context) {
+        return CostPipeline<Rest...>::add(cost + Term::weight*Term::eval(subject, context), subject, context);
+    }
+
+    template <class Subject, class Context>
+    static float cost(const Subject &subject, const Context &context) { return add(0.0f, subject, context); }
+
+    template <class Subject, class Context>
+    static void batch(const Subject *subjects, int n, const Context &context, float *costs) {
+        for (int i = 0; i < n; i++) costs[i] = add(0.0f, subjects[i], context);
+    }
+};
+
+#endif
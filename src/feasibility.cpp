@@ -0,0 +1,171 @@
+#include "feasibility.h"
+#include <algorithm>
+#include <math.h>
+
+// column layout of the derivative coefficients: speed (5 each), acceleration (4 each) and jerk (3 each) along s and d
+enum { S_VEL = 0, D_VEL = 5, S_ACC = 10, D_ACC = 14, S_JERK = 18, D_JERK = 21, DERIVATIVE_COLUMNS = 24 };
+
+static void limits_kernel(const float * __restrict c, const float * __restrict duration, float t, float min_speed2, int n,
+                          float * __restrict max_v2, float * __restrict max_a2, float * __restrict max_j2,
+                          float * __restrict max_k2) {
+    for (int i = 0; i < n; i++) {
+        const float *r = c + i;
+        float vs = (((r[(S_VEL + 4)*n]*t + r[(S_VEL + 3)*n])*t + r[(S_VEL + 2)*n])*t + r[(S_VEL + 1)*n])*t + r[S_VEL*n];
+        float vd = (((r[(D_VEL + 4)*n]*t + r[(D_VEL + 3)*n])*t + r[(D_VEL + 2)*n])*t + r[(D_VEL + 1)*n])*t + r[D_VEL*n];
+        float as = ((r[(S_ACC + 3)*n]*t + r[(S_ACC + 2)*n])*t + r[(S_ACC + 1)*n])*t + r[S_ACC*n];
+        float ad = ((r[(D_ACC + 3)*n]*t + r[(D_ACC + 2)*n])*t + r[(D_ACC + 1)*n])*t + r[D_ACC*n];
+        float js = (r[(S_JERK + 2)*n]*t + r[(S_JERK + 1)*n])*t + r[S_JERK*n];
+        float jd = (r[(D_JERK + 2)*n]*t + r[(D_JERK + 1)*n])*t + r[D_JERK*n];
+        float inside = t <= duration[i] ? 1.0f : 0.0f;
+        float v2 = vs*vs + vd*vd;
+        float a2 = as*as + ad*ad;
+        float j2 = js*js + jd*jd;
+        float cross = vs*ad - vd*as;
+        // curvature^2 = cross^2/|v|^6; the division also runs for slow rows, whose result is dropped
+        float k2 = cross*cross/(v2*v2*v2 + 1e-12f);
+        k2 = v2 >= min_speed2 ? k2 : 0.0f;
+        v2 *= inside;
+        a2 *= inside;
+        j2 *= inside;
+        k2 *= inside;
+        max_v2[i] = v2 > max_v2[i] ? v2 : max_v2[i];
+        max_a2[i] = a2 > max_a2[i] ? a2 : max_a2[i];
+        max_j2[i] = j2 > max_j2[i] ? j2 : max_j2[i];
+        max_k2[i] = k2 > max_k2[i] ? k2 : max_k2[i];
+    }
+}
+
+static void speed_kernel(const double * __restrict x0, const double * __restrict x1, const double * __restrict y0,
+                         const double * __restrict y1, double inv_dt, int n, float * __restrict max_v2) {
+    for (int i = 0; i < n; i++) {
+        double vx = (x1[i] - x0[i])*inv_dt;
+        double vy = (y1[i] - y0[i])*inv_dt;
+        float v2 = vx*vx + vy*vy;
+        max_v2[i] = v2 > max_v2[i] ? v2 : max_v2[i];
+    }
+}
+
+static void accel_kernel(const double * __restrict x0, const double * __restrict x1, const double * __restrict x2,
+                         const double * __restrict y0, const double * __restrict y1, const double * __restrict y2,
+                         double inv_dt, double min_step2, int n, float * __restrict max_a2, float * __restrict max_k2) {
+    for (int i = 0; i < n; i++) {
+        double ux = x1[i] - x0[i];
+        double uy = y1[i] - y0[i];
+        double wx = x2[i] - x1[i];
+        double wy = y2[i] - y1[i];
+        double ax = (wx - ux)*inv_dt*inv_dt;
+        double ay = (wy - uy)*inv_dt*inv_dt;
+        float a2 = ax*ax + ay*ay;
+        // Menger curvature of the three points: 2 |u x w| / (|u| |w| |u + w|)
+        double cross = ux*wy - uy*wx;
+        double u2 = ux*ux + uy*uy;
+        double w2 = wx*wx + wy*wy;
+        double sx = ux + wx;
+        double sy = uy + wy;
+        double k2 = 4*cross*cross/(u2*w2*(sx*sx + sy*sy) + 1e-30);
+        float curvature2 = u2 >= min_step2 && w2 >= min_step2 ? k2 : 0.0;
+        max_a2[i] = a2 > max_a2[i] ? a2 : max_a2[i];
+        max_k2[i] = curvature2 > max_k2[i] ? curvature2 : max_k2[i];
+    }
+}
+
+static void jerk_kernel(const double * __restrict x0, const double * __restrict x1, const double * __restrict x2,
+                        const double * __restrict x3, const double * __restrict y0, const double * __restrict y1,
+                        const double * __restrict y2, const double * __restrict y3, double inv_dt3, int n,
+                        float * __restrict max_j2) {
+    for (int i = 0; i < n; i++) {
+        double jx = (x3[i] - 3*x2[i] + 3*x1[i] - x0[i])*inv_dt3;
+        double jy = (y3[i] - 3*y2[i] + 3*y1[i] - y0[i])*inv_dt3;
+        float j2 = jx*jx + jy*jy;
+        max_j2[i] = j2 > max_j2[i] ? j2 : max_j2[i];
+    }
+}
+
+FeasibilityChecker::FeasibilityChecker() {}
+
+FeasibilityChecker::~FeasibilityChecker() {}
+
+int FeasibilityChecker::count_feasible() const {
+    int count = 0;
+    for (int i = 0; i < size(); i++) count += this->feasible[i];
+    return count;
+}
+
+void FeasibilityChecker::resize(int n) {
+    // the maxima are accumulated squared and start at 0
+    this->feasible.resize(n);
+    this->max_speed.assign(n, 0);
+    this->max_accel.assign(n, 0);
+    this->max_jerk.assign(n, 0);
+    this->max_curvature.assign(n, 0);
+}
+
+void FeasibilityChecker::finish(const FeasibilityLimits &limits) {
+    for (int i = 0; i < size(); i++) {
+        this->max_speed[i] = sqrt(this->max_speed[i]);
+        this->max_accel[i] = sqrt(this->max_accel[i]);
+        this->max_jerk[i] = sqrt(this->max_jerk[i]);
+        this->max_curvature[i] = sqrt(this->max_curvature[i]);
+        this->feasible[i] = this->max_speed[i] <= limits.max_speed && this->max_accel[i] <= limits.max_accel
+                            && this->max_jerk[i] <= limits.max_jerk && this->max_curvature[i] <= limits.max_curvature;
+    }
+}
+
+void FeasibilityChecker::check(const TrajectorySet &set, const FeasibilityLimits &limits) {
+    /*
+    The derivative polynomials of every row are converted once to float columns. Every time
+    step then evaluates them by Horner's rule across all rows in one pass and folds the step
+    into the running maxima.
+    */
+    int n = set.size();
+    resize(n);
+    this->duration.assign(set.T.begin(), set.T.end());
+    float max_duration = 0;
+    for (int i = 0; i < n; i++) max_duration = max(max_duration, set.T[i]);
+    this->derivatives.resize(DERIVATIVE_COLUMNS*n);
+    float *c = this->derivatives.data();
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < 5; k++) {
+            c[(S_VEL + k)*n + i] = (k + 1)*set.s_coef[k + 1][i];
+            c[(D_VEL + k)*n + i] = (k + 1)*set.d_coef[k + 1][i];
+        }
+        for (int k = 0; k < 4; k++) {
+            c[(S_ACC + k)*n + i] = (k + 1)*(k + 2)*set.s_coef[k + 2][i];
+            c[(D_ACC + k)*n + i] = (k + 1)*(k + 2)*set.d_coef[k + 2][i];
+        }
+        for (int k = 0; k < 3; k++) {
+            c[(S_JERK + k)*n + i] = (k + 1)*(k + 2)*(k + 3)*set.s_coef[k + 3][i];
+            c[(D_JERK + k)*n + i] = (k + 1)*(k + 2)*(k + 3)*set.d_coef[k + 3][i];
+        }
+    }
+
+    int steps = (int) (max_duration/limits.dt) + 1;
+    float min_speed2 = limits.min_curvature_speed*limits.min_curvature_speed;
+    for (int step = 0; step <= steps; step++) {
+        float t = min(step*limits.dt, max_duration);
+        limits_kernel(c, this->duration.data(), t, min_speed2, n,
+                      this->max_speed.data(), this->max_accel.data(), this->max_jerk.data(), this->max_curvature.data());
+    }
+    finish(limits);
+}
+
+void FeasibilityChecker::check_sampled(const double *x, const double *y, int points, int n, const FeasibilityLimits &limits) {
+    /*
+    Speed from every pair of consecutive points, acceleration and curvature from every three,
+    jerk from every four.
+    */
+    resize(n);
+    double inv_dt = 1.0/limits.dt;
+    double min_step = limits.min_curvature_speed*limits.dt;
+    for (int p = 1; p < points; p++) {
+        const double *x1 = x + p*n, *y1 = y + p*n;
+        speed_kernel(x1 - n, x1, y1 - n, y1, inv_dt, n, this->max_speed.data());
+        if (p < 2) continue;
+        accel_kernel(x1 - 2*n, x1 - n, x1, y1 - 2*n, y1 - n, y1, inv_dt, min_step*min_step, n,
+                     this->max_accel.data(), this->max_curvature.data());
+        if (p < 3) continue;
+        jerk_kernel(x1 - 3*n, x1 - 2*n, x1 - n, x1, y1 - 3*n, y1 - 2*n, y1 - n, y1, inv_dt*inv_dt*inv_dt, n,
+                    this->max_jerk.data());
+    }
+    finish(limits);
+}
@@ -0,0 +1,77 @@
+#ifndef FEASIBILITY_H
+#define FEASIBILITY_H
+#include <stdint.h>
+#include <vector>
+#include "trajectory_set.h"
+
+using namespace std;
+
+/*
+ * Limits a drivable trajectory stays within at every checked time step.
+ */
+struct FeasibilityLimits {
+    float max_speed = 22.35; // m/s, the simulator's 50 MPH
+    float max_accel = 10; // total, m/s^2
+    float max_jerk = 10; // total, m/s^3
+    float max_curvature = 0.2; // 1/m
+    float min_curvature_speed = 1; // m/s, the heading of a car slower than this is not checked
+    float dt = 0.02; // s between checked time steps, the simulator's point spacing
+};
+
+/*
+ * Batch feasibility check of many trajectories at once. Speed, total acceleration,
+ * total jerk and curvature are evaluated every dt along each trajectory; the
+ * results are one row per trajectory in parallel columns, kept until the next
+ * check. The inner loops run across trajectories, one time step at a time, so
+ * the compiler vectorizes them over contiguous columns.
+ */
+class FeasibilityChecker {
+public:
+
+    // results of the last check, one row per trajectory
+    vector<uint8_t> feasible;
+    vector<float> max_speed;
+    vector<float> max_accel;
+    vector<float> max_jerk;
+    vector<float> max_curvature;
+
+    /**
+    * Constructor
+    */
+    FeasibilityChecker();
+
+    /**
+    * Destructor
+    */
+    virtual ~FeasibilityChecker();
+
+    int size() const { return this->feasible.size(); }
+
+    int count_feasible() const;
+
+    /*
+     * Checks the s(t) and d(t) quintics of every row of set over [0, T]. The
+     * motion is taken in the Frenet frame, so the curvature of the road itself
+     * is not included.
+     */
+    void check(const TrajectorySet &set, const FeasibilityLimits &limits);
+
+    /*
+     * Checks n sampled x, y paths of points points each, one point every
+     * limits.dt seconds, with finite differences. Point p of path i is at
+     * index p*n + i.
+     */
+    void check_sampled(const double *x, const double *y, int points, int n, const FeasibilityLimits &limits);
+
+private:
+
+    void resize(int n);
+
+    void finish(const FeasibilityLimits &limits);
+
+    // coefficients of the derivative polynomials of the rows being checked, column-major
+    vector<float> derivatives;
+    vector<float> duration;
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "flight_recorder.h"
+#include "road.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+// every candidate of a decision fits in a frame
+static_assert(MAX_SUCCESSORS <= REC_MAX_CANDIDATES, "REC_MAX_CANDIDATES must cover the largest successor list");
+
+static FlightRecorder *active_recorder = NULL;
+
+static void copy_state(char *dst, State state) {
+    strncpy(dst, state_name(state), REC_STATE_LEN - 1);
+    dst[REC_STATE_LEN - 1] = '\0';
+}
+
+static void fill_vehicle(RecVehicle &rec, int id, const Vehicle &vehicle) {
+    rec.id = id;
+    rec.lane = vehicle.lane;
+    rec.s = vehicle.s;
+    rec.d = vehicle.d;
+    rec.v_s = vehicle.v_s;
+    rec.a_s = vehicle.a_s;
+}
+
+static void on_dump_signal(int) {
+    if (active_recorder != NULL) {
+        active_recorder->dump();
+    }
+}
+
+static void on_fatal_signal(int sig) {
+    /*
+    Flush whatever we have, then let the default action terminate the process.
+    */
+    if (active_recorder != NULL) {
+        active_recorder->dump();
+    }
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+FlightRecorder::FlightRecorder() {
+    this->header = NULL;
+    this->frames = NULL;
+    this->map_size = 0;
+    this->dump_path[0] = '\0';
+}
+
+FlightRecorder::~FlightRecorder() {
+    close();
+}
+
+bool FlightRecorder::open(const string &path, int capacity) {
+    close();
+    if (capacity <= 0 || path.size() + 6 > sizeof(this->dump_path)) return false;
+
+    // the previous run's ring is kept as path.prev, so a restart does not wipe the evidence of a crash
+    string previous = path + ".prev";
+    if (rename(path.c_str(), previous.c_str()) != 0 && errno != ENOENT) return false;
+
+    size_t size = sizeof(RecHeader) + sizeof(RecFrame) * capacity;
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    if (ftruncate(fd, size) != 0) {
+        ::close(fd);
+        return false;
+    }
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) return false;
+
+    this->map_size = size;
+    this->header = (RecHeader *) mem;
+    this->frames = (RecFrame *) ((char *) mem + sizeof(RecHeader));
+    this->header->magic = REC_MAGIC;
+    this->header->version = REC_VERSION;
+    this->header->frame_size = sizeof(RecFrame);
+    this->header->capacity = capacity;
+    this->header->next_seq = 1;
+    strcpy(this->dump_path, path.c_str());
+    strcat(this->dump_path, ".dump");
+    return true;
+}
+
+void FlightRecorder::close() {
+    if (this->header == NULL) return;
+    if (active_recorder == this) active_recorder = NULL;
+    msync(this->header, this->map_size, MS_SYNC);
+    munmap(this->header, this->map_size);
+    this->header = NULL;
+    this->frames = NULL;
+    this->map_size = 0;
+}
+
+bool FlightRecorder::is_open() const {
+    return this->header != NULL;
+}
+
+void FlightRecorder::install_signal_handlers() {
+    active_recorder = this;
+    signal(SIGUSR1, on_dump_signal);
+    signal(SIGSEGV, on_fatal_signal);
+    signal(SIGBUS, on_fatal_signal);
+    signal(SIGFPE, on_fatal_signal);
+    signal(SIGABRT, on_fatal_signal);
+}
+
+void FlightRecorder::record(const Road &road, const frame_vector<double> &next_x, const frame_vector<double> &next_y) {
+    /*
+    Writes one snapshot into the next ring slot. The sequence number is cleared first and
+    published last, so a frame torn by a crash is skipped by the decoder.
+    */
+    if (this->header == NULL) return;
+
+    uint64_t seq = this->header->next_seq;
+    RecFrame &frame = this->frames[seq % this->header->capacity];
+    frame.seq = 0;
+    __sync_synchronize();
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    frame.t_us = (int64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+
+    fill_vehicle(frame.ego, road.ego_key, road.ego);
+    frame.target_lane = road.ego.target_lane;
+    copy_state(frame.ego_state, road.ego.state);
+
+    const TrafficTable &traffic = road.traffic;
+    int count = min(traffic.size(), REC_MAX_VEHICLES);
+    for (int i = 0; i < count; i++) {
+        RecVehicle &rec = frame.vehicles[i];
+        rec.id = traffic.id[i];
+        rec.lane = traffic.lane[i];
+        rec.s = traffic.s[i];
+        rec.d = traffic.d[i];
+        rec.v_s = traffic.v_s[i];
+        rec.a_s = traffic.a_s[i];
+    }
+    frame.num_vehicles = count;
+    frame.num_culled = road.vehicles_culled;
+
+    const Vehicle::decision &decision = road.last_decision;
+    int num_candidates = min((int) decision.states.size(), REC_MAX_CANDIDATES);
+    for (int i = 0; i < num_candidates; i++) {
+        copy_state(frame.candidates[i].state, decision.states[i]);
+        frame.candidates[i].cost = decision.costs[i];
+    }
+    frame.num_candidates = num_candidates;
+    frame.chosen = decision.best < num_candidates ? decision.best : -1;
+
+    int num_points = min((int) next_x.size(), REC_MAX_POINTS);
+    for (int i = 0; i < num_points; i++) {
+        frame.next_x[i] = next_x[i];
+        frame.next_y[i] = next_y[i];
+    }
+    frame.num_points = num_points;
+
+    __sync_synchronize();
+    frame.seq = seq;
+    this->header->next_seq = seq + 1;
+}
+
+bool FlightRecorder::dump() const {
+    // the shared mapping reaches the file without an msync, which is not async-signal-safe
+    if (this->header == NULL) return false;
+    int fd = ::open(this->dump_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    const char *p = (const char *) this->header;
+    size_t left = this->map_size;
+    while (left > 0) {
+        ssize_t n = write(fd, p, left);
+        if (n <= 0) break;
+        p += n;
+        left -= n;
+    }
+    ::close(fd);
+    return left == 0;
+}
@@ -0,0 +1,101 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "frame_arena.h"
+
+using namespace std;
+
+class Road;
+
+/*
+ * On-disk layout of the flight recorder. Everything below is plain old data so the
+ * ring can live directly in a shared file mapping and be read back by recorder_decode.
+ */
+const uint32_t REC_MAGIC = 0x31524650; // "PFR1"
+const uint32_t REC_VERSION = 2;
+const int REC_MAX_VEHICLES = 32;
+const int REC_MAX_CANDIDATES = 8;
+const int REC_MAX_POINTS = 50;
+const int REC_STATE_LEN = 8;
+
+struct RecVehicle {
+    int32_t id;
+    int32_t lane;
+    float s;
+    float d;
+    float v_s;
+    float a_s;
+};
+
+struct RecCandidate {
+    char state[REC_STATE_LEN];
+    float cost;
+};
+
+struct RecFrame {
+    uint64_t seq; // 0 while the slot is being written
+    int64_t t_us; // wall clock, microseconds since epoch
+    RecVehicle ego;
+    int32_t target_lane;
+    char ego_state[REC_STATE_LEN];
+    int32_t chosen; // index into candidates, -1 if no decision was taken this frame
+    int32_t num_vehicles;
+    int32_t num_culled; // vehicles dropped by Road::cull, not in vehicles
+    int32_t num_candidates;
+    int32_t num_points;
+    RecVehicle vehicles[REC_MAX_VEHICLES];
+    RecCandidate candidates[REC_MAX_CANDIDATES];
+    float next_x[REC_MAX_POINTS];
+    float next_y[REC_MAX_POINTS];
+};
+
+struct RecHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t frame_size;
+    uint32_t capacity;
+    uint64_t next_seq;
+};
+
+class FlightRecorder {
+public:
+
+    /**
+    * Constructor
+    */
+    FlightRecorder();
+
+    /**
+    * Destructor
+    */
+    virtual ~FlightRecorder();
+
+    /*
+     * Maps a ring of `capacity` frames backed by `path`. The file keeps the data if the
+     * process dies; a copy is written to `path`.dump on SIGUSR1 or on a fatal signal.
+     * A ring left at `path` by the previous run is first moved to `path`.prev.
+     */
+    bool open(const string &path, int capacity);
+
+    void close();
+
+    bool is_open() const;
+
+    void install_signal_handlers();
+
+    void record(const Road &road, const frame_vector<double> &next_x, const frame_vector<double> &next_y);
+
+    // async-signal-safe: only uses open/write/close
+    bool dump() const;
+
+private:
+
+    RecHeader *header;
+    RecFrame *frames;
+    size_t map_size;
+    char dump_path[512];
+};
+
+#endif
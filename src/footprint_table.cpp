@@ -0,0 +1,49 @@
+#include "footprint_table.h"
+#include "prediction_store.h"
+
+FootprintTable::FootprintTable() {}
+
+FootprintTable::~FootprintTable() {}
+
+void FootprintTable::reserve(int rows) {
+    this->rows_reserved = rows;
+    this->s.reserve(rows);
+    this->d.reserve(rows);
+    this->v.reserve(rows);
+    this->d_dot.reserve(rows);
+}
+
+void FootprintTable::build(const PredictionStore &predictions, const FrenetMap &frenet, float horizon) {
+    /*
+    Every step evaluates the predictions in one batch and converts them to Cartesian in another.
+    The step columns are sized for the reserved rows, so a frame with more traffic than the last
+    one does not reallocate them.
+    */
+    int n = predictions.size();
+    this->n = n;
+    this->num_steps = (int) ceil(horizon/this->time_step - 1e-3f) + 1;
+    int capacity = this->num_steps*max(n, this->rows_reserved);
+    this->center_x.reserve(capacity);
+    this->center_y.reserve(capacity);
+    this->head_x.reserve(capacity);
+    this->head_y.reserve(capacity);
+    this->center_x.resize(this->num_steps*n);
+    this->center_y.resize(this->num_steps*n);
+    this->head_x.resize(this->num_steps*n);
+    this->head_y.resize(this->num_steps*n);
+    this->s.resize(n);
+    this->d.resize(n);
+    this->v.resize(n);
+    this->d_dot.resize(n);
+    for (int i = 0; i < n; i++) {
+        this->d_dot[i] = predictions.d_dot(i);
+    }
+    for (int k = 0; k < this->num_steps; k++) {
+        float t = k*this->time_step;
+        predictions.s_at(t, this->s.data());
+        predictions.d_at(t, this->d.data());
+        predictions.v_at(t, this->v.data());
+        frenet.to_cartesian(this->s.data(), this->d.data(), this->v.data(), this->d_dot.data(), n,
+                            &this->center_x[k*n], &this->center_y[k*n], &this->head_x[k*n], &this->head_y[k*n]);
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef FOOTPRINT_TABLE_H
+#define FOOTPRINT_TABLE_H
+#include <math.h>
+#include <vector>
+#include "frenet_map.h"
+
+using namespace std;
+
+class PredictionStore;
+
+const int FOOTPRINT_CIRCLES = 3;
+
+/*
+ * Outline of a vehicle as FOOTPRINT_CIRCLES equal circles centered along its
+ * heading, together covering its length x width rectangle.
+ */
+struct Footprint {
+    float length = 4.8; // m
+    float width = 2.0; // m
+
+    // distance of the center of circle k ahead of the vehicle's center
+    float offset(int k) const { return (k - 0.5f*(FOOTPRINT_CIRCLES - 1))*this->length/FOOTPRINT_CIRCLES; }
+
+    float radius() const {
+        float half = 0.5f*this->length/FOOTPRINT_CIRCLES;
+        return sqrt(half*half + 0.25f*this->width*this->width);
+    }
+
+    // radius around the vehicle's center holding every circle
+    float reach() const { return offset(FOOTPRINT_CIRCLES - 1) + radius(); }
+};
+
+/*
+ * Per-frame Cartesian footprints of the predicted traffic: the center and unit
+ * heading of every vehicle at every time step over the horizon, one column per
+ * step. Collision checks read
+ * the columns of a step across all vehicles at once. Rebuilt in place every
+ * frame without touching the heap.
+ */
+class FootprintTable {
+public:
+
+    Footprint footprint; // of every vehicle
+    float time_step = 0.1; // s
+
+    /**
+    * Constructor
+    */
+    FootprintTable();
+
+    /**
+    * Destructor
+    */
+    virtual ~FootprintTable();
+
+    // places every prediction at every step over [0, horizon] seconds on frenet
+    void build(const PredictionStore &predictions, const FrenetMap &frenet, float horizon);
+
+    // makes room for rows vehicles
+    void reserve(int rows);
+
+    int size() const { return this->n; }
+
+    int steps() const { return this->num_steps; }
+
+    // centers and unit headings of every vehicle at step k, size() values each
+    const float *x(int k) const { return &this->center_x[k*this->n]; }
+    const float *y(int k) const { return &this->center_y[k*this->n]; }
+    const float *heading_x(int k) const { return &this->head_x[k*this->n]; }
+    const float *heading_y(int k) const { return &this->head_y[k*this->n]; }
+
+private:
+
+    int n = 0;
+    int num_steps = 0;
+    int rows_reserved = 0;
+    vector<float> center_x, center_y, head_x, head_y; // steps x n
+    // scratch of one step
+    vector<float> s, d, v, d_dot;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "frame_arena.h"
+#include <new>
+#include <stdint.h>
+#include <stdlib.h>
+
+thread_local FrameArena frame_arena;
+
+FrameArena::FrameArena(size_t block_size) {
+    this->block_size = block_size;
+    this->current = 0;
+    this->offset = 0;
+    this->in_use = 0;
+    this->peak = 0;
+}
+
+FrameArena::~FrameArena() {
+    for (size_t i = 0; i < this->blocks.size(); i++) {
+        free(this->blocks[i]);
+    }
+}
+
+void FrameArena::add_block(size_t min_bytes) {
+    size_t size = min_bytes > this->block_size ? min_bytes : this->block_size;
+    char *block = (char *) malloc(size);
+    if (block == NULL) throw std::bad_alloc();
+    this->blocks.push_back(block);
+    this->block_sizes.push_back(size);
+}
+
+void *FrameArena::allocate(size_t bytes, size_t align) {
+    /*
+    Bumps within the current block; an allocation that does not fit moves on to the next
+    block, adding one large enough if needed.
+    */
+    while (this->current < this->blocks.size()) {
+        uintptr_t base = (uintptr_t) this->blocks[this->current];
+        uintptr_t start = (base + this->offset + align - 1) & ~(uintptr_t) (align - 1);
+        if (start + bytes <= base + this->block_sizes[this->current]) {
+            this->offset = start + bytes - base;
+            this->in_use += bytes;
+            if (this->in_use > this->peak) this->peak = this->in_use;
+            return (void *) start;
+        }
+        this->current++;
+        this->offset = 0;
+    }
+    add_block(bytes + align);
+    return allocate(bytes, align);
+}
+
+void FrameArena::reset() {
+    if (this->blocks.size() > 1) {
+        size_t total = 0;
+        for (size_t i = 0; i < this->blocks.size(); i++) {
+            total += this->block_sizes[i];
+            free(this->blocks[i]);
+        }
+        this->blocks.clear();
+        this->block_sizes.clear();
+        this->block_size = total;
+        add_block(total);
+    }
+    this->current = 0;
+    this->offset = 0;
+    this->in_use = 0;
+}
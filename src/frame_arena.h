@@ -0,0 +1,86 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+#include <stddef.h>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Monotonic arena for the temporaries of one planning cycle. Allocation bumps an
+ * offset in the current block, freeing is a no-op, and reset() at the start of
+ * every telemetry message recycles everything at once. Blocks are kept across
+ * resets; when a cycle needed more than one, they are merged into one block of
+ * the combined size, so after a few cycles the arena never calls malloc.
+ * Memory from the arena must not outlive the cycle it was taken in.
+ */
+class FrameArena {
+public:
+
+    /**
+    * Constructor
+    */
+    FrameArena(size_t block_size = 64*1024);
+
+    /**
+    * Destructor
+    */
+    virtual ~FrameArena();
+
+    void *allocate(size_t bytes, size_t align);
+
+    // releases everything allocated since the last reset
+    void reset();
+
+    // bytes handed out since the last reset
+    size_t used() const { return this->in_use; }
+
+    // most bytes handed out in one cycle
+    size_t high_water() const { return this->peak; }
+
+private:
+
+    FrameArena(const FrameArena &);
+    FrameArena &operator=(const FrameArena &);
+
+    void add_block(size_t min_bytes);
+
+    size_t block_size;
+    vector<char *> blocks;
+    vector<size_t> block_sizes;
+    size_t current; // block being filled
+    size_t offset; // within the current block
+    size_t in_use;
+    size_t peak;
+};
+
+// arena of the calling thread; the planning thread resets it every cycle, pool workers every batch
+extern thread_local FrameArena frame_arena;
+
+/*
+ * Standard allocator over the calling thread's frame_arena, so planner containers can live in it:
+ * frame_vector<T> is a vector<T> whose storage is recycled every cycle.
+ */
+template <class T>
+struct ArenaAllocator {
+    typedef T value_type;
+
+    ArenaAllocator() {}
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U> &) {}
+
+    T *allocate(size_t n) { return (T *) frame_arena.allocate(n*sizeof(T), alignof(T)); }
+
+    void deallocate(T *, size_t) {}
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T> &, const ArenaAllocator<U> &) { return true; }
+
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T> &, const ArenaAllocator<U> &) { return false; }
+
+template <class T>
+using frame_vector = vector<T, ArenaAllocator<T>>;
+
+#endif
@@ -0,0 +1,141 @@
+#include "frenet_map.h"
+#include <math.h>
+
+FrenetMap::FrenetMap() {
+    this->loop_length = 0;
+    this->bins_per_meter = 1/FRENET_BIN;
+}
+
+FrenetMap::~FrenetMap() {}
+
+void FrenetMap::build(const vector<double> &maps_s, const vector<double> &maps_x, const vector<double> &maps_y,
+                      const vector<double> &maps_dx, const vector<double> &maps_dy, double length) {
+    /*
+    Every bin gets the position and the normal linearly interpolated between the waypoints around
+    its center, the normal renormalized. The last segment wraps from the last waypoint to the first
+    one, a lap later.
+    */
+    this->normal_x.clear();
+    this->normal_y.clear();
+    this->point_x.clear();
+    this->point_y.clear();
+    this->loop_length = length;
+    int waypoints = maps_s.size();
+    if (waypoints == 0 || length <= 0) return;
+
+    int bins = (int) ceil(length*this->bins_per_meter);
+    this->normal_x.resize(bins);
+    this->normal_y.resize(bins);
+    this->point_x.resize(bins);
+    this->point_y.resize(bins);
+    int wp = 0;
+    for (int b = 0; b < bins; b++) {
+        double s = (b + 0.5)*FRENET_BIN;
+        while (wp + 1 < waypoints && maps_s[wp + 1] <= s) wp++;
+        int next = (wp + 1) % waypoints;
+        double s0 = maps_s[wp];
+        double s1 = next == 0 ? maps_s[0] + length : maps_s[next];
+        if (s < s0) { // before the first waypoint: on the wrapping segment
+            s0 -= length;
+        }
+        double t = s1 > s0 ? (s - s0)/(s1 - s0) : 0;
+        t = t < 0 ? 0 : t > 1 ? 1 : t;
+        double nx = maps_dx[wp] + t*(maps_dx[next] - maps_dx[wp]);
+        double ny = maps_dy[wp] + t*(maps_dy[next] - maps_dy[wp]);
+        double norm = sqrt(nx*nx + ny*ny);
+        if (norm > 0) {
+            nx /= norm;
+            ny /= norm;
+        }
+        this->normal_x[b] = nx;
+        this->normal_y[b] = ny;
+        this->point_x[b] = maps_x[wp] + t*(maps_x[next] - maps_x[wp]);
+        this->point_y[b] = maps_y[wp] + t*(maps_y[next] - maps_y[wp]);
+    }
+}
+
+static void project_kernel(const float * __restrict s, const float * __restrict vx, const float * __restrict vy, int n,
+                           const float * __restrict nx_table, const float * __restrict ny_table, int last, float scale,
+                           float * __restrict s_dot, float * __restrict d_dot) {
+    for (int i = 0; i < n; i++) {
+        // a slightly negative s wraps to a huge index and lands on the last bin, the end of the lap
+        unsigned bin = (unsigned) (int) (s[i]*scale);
+        bin = bin > (unsigned) last ? last : bin;
+        float nx = nx_table[bin];
+        float ny = ny_table[bin];
+        // tangent (-ny, nx)
+        s_dot[i] = nx*vy[i] - ny*vx[i];
+        d_dot[i] = nx*vx[i] + ny*vy[i];
+    }
+}
+
+void FrenetMap::project_velocities(const float *s, const float *vx, const float *vy, int n,
+                                   float *s_dot, float *d_dot) const {
+    if (empty()) {
+        for (int i = 0; i < n; i++) {
+            s_dot[i] = sqrt(vx[i]*vx[i] + vy[i]*vy[i]);
+            d_dot[i] = 0;
+        }
+        return;
+    }
+    project_kernel(s, vx, vy, n, this->normal_x.data(), this->normal_y.data(), this->normal_x.size() - 1,
+                   this->bins_per_meter, s_dot, d_dot);
+}
+
+static void frame_kernel(const float * __restrict s, int n, const float * __restrict px_table,
+                         const float * __restrict py_table, const float * __restrict nx_table,
+                         const float * __restrict ny_table, int last, float scale, float length,
+                         float * __restrict px, float * __restrict py, float * __restrict nx, float * __restrict ny) {
+    // the frame under every s, moved along the tangent (-ny, nx) from the middle of its bin
+    for (int i = 0; i < n; i++) {
+        float si = s[i] >= length ? s[i] - length : s[i] < 0 ? s[i] + length : s[i];
+        int bin = (int) (si*scale);
+        bin = bin > last ? last : bin;
+        float along = si - (bin + 0.5f)/scale;
+        nx[i] = nx_table[bin];
+        ny[i] = ny_table[bin];
+        px[i] = px_table[bin] - along*ny[i];
+        py[i] = py_table[bin] + along*nx[i];
+    }
+}
+
+static void cartesian_kernel(const float * __restrict d, const float * __restrict s_dot, const float * __restrict d_dot,
+                             int n, float * __restrict x, float * __restrict y, float * __restrict heading_x,
+                             float * __restrict heading_y) {
+    // x, y come in holding the frame's point and heading_x, heading_y its normal
+    for (int i = 0; i < n; i++) {
+        float nx = heading_x[i];
+        float ny = heading_y[i];
+        x[i] += d[i]*nx;
+        y[i] += d[i]*ny;
+        float v2 = s_dot[i]*s_dot[i] + d_dot[i]*d_dot[i];
+        float moving = v2 > 1e-6f ? 1.0f : 0.0f;
+        float inv = moving/sqrt(v2 + 1e-6f);
+        float hs = s_dot[i]*inv + (1 - moving);
+        float hd = d_dot[i]*inv;
+        heading_x[i] = -hs*ny + hd*nx;
+        heading_y[i] = hs*nx + hd*ny;
+    }
+}
+
+void FrenetMap::to_cartesian(const float *s, const float *d, const float *s_dot, const float *d_dot, int n,
+                             float *x, float *y, float *heading_x, float *heading_y) const {
+    /*
+    The table lookups run in one pass and the arithmetic in a second one, which vectorizes. The
+    moving vehicles' headings are normalized with one square root each; the ones at rest get
+    (1, 0) in the Frenet frame.
+    */
+    if (empty()) {
+        for (int i = 0; i < n; i++) {
+            float v = sqrt(s_dot[i]*s_dot[i] + d_dot[i]*d_dot[i]);
+            x[i] = s[i];
+            y[i] = -d[i];
+            heading_x[i] = v > 1e-3f ? s_dot[i]/v : 1;
+            heading_y[i] = v > 1e-3f ? -d_dot[i]/v : 0;
+        }
+        return;
+    }
+    frame_kernel(s, n, this->point_x.data(), this->point_y.data(), this->normal_x.data(), this->normal_y.data(),
+                 this->normal_x.size() - 1, this->bins_per_meter, this->loop_length, x, y, heading_x, heading_y);
+    cartesian_kernel(d, s_dot, d_dot, n, x, y, heading_x, heading_y);
+}
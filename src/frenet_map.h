@@ -0,0 +1,65 @@
+#ifndef FRENET_MAP_H
+#define FRENET_MAP_H
+#include <vector>
+
+using namespace std;
+
+const float FRENET_BIN = 1.0; // s resolution of the precomputed frame table, meters
+
+/*
+ * Precomputed Frenet frames along the track. The waypoint positions and normals
+ * (dx, dy) are interpolated once into tables of reference points and unit normals
+ * sampled every FRENET_BIN meters of s, so looking up the frame at any s is one
+ * index computation and a few loads. The tangent is the normal turned 90 degrees
+ * to the left, matching getXY().
+ */
+class FrenetMap {
+public:
+
+    /**
+    * Constructor
+    */
+    FrenetMap();
+
+    /**
+    * Destructor
+    */
+    virtual ~FrenetMap();
+
+    // builds the tables from the map waypoints; length is the s of a full lap
+    void build(const vector<double> &maps_s, const vector<double> &maps_x, const vector<double> &maps_y,
+               const vector<double> &maps_dx, const vector<double> &maps_dy, double length);
+
+    bool empty() const { return this->normal_x.empty(); }
+
+    float length() const { return this->loop_length; }
+
+    /*
+     * Splits n Cartesian velocities (vx, vy) of vehicles at s into the speed along the
+     * road (s_dot) and across it (d_dot, positive away from the center line).
+     * Without a map all of the speed is taken as longitudinal.
+     */
+    void project_velocities(const float *s, const float *vx, const float *vy, int n,
+                            float *s_dot, float *d_dot) const;
+
+    /*
+     * Converts n Frenet states (s, d and their speeds) into Cartesian positions
+     * (x, y) and unit headings (heading_x, heading_y); a vehicle at rest heads
+     * along the road. s wraps around the lap. Without a map the road is taken
+     * as straight along x, with d growing towards -y.
+     */
+    void to_cartesian(const float *s, const float *d, const float *s_dot, const float *d_dot, int n,
+                      float *x, float *y, float *heading_x, float *heading_y) const;
+
+private:
+
+    float loop_length;
+    float bins_per_meter;
+    vector<float> normal_x;
+    vector<float> normal_y;
+    // reference point on the center line at the middle of every bin
+    vector<float> point_x;
+    vector<float> point_y;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "hypothesis_pool.h"
+#include "prediction_store.h"
+#include "road_model.h"
+#include <math.h>
+
+const float LATERAL_LOOKAHEAD = 1.0; // s of lateral drift folded into the lane position
+const float CHANGE_THRESHOLD = 0.5; // predicted offset, in half lane widths, where a change is as likely as not
+const float CHANGE_SHARPNESS = 6.0;
+const float MIN_WEIGHT = 0.02; // lighter hypotheses are dropped
+
+HypothesisPool::HypothesisPool() {}
+
+HypothesisPool::~HypothesisPool() {}
+
+void HypothesisPool::reserve(int rows) {
+    // at most keep, left and right per vehicle
+    this->vehicle.reserve(3*rows);
+    this->lane.reserve(3*rows);
+    this->maneuver.reserve(3*rows);
+    this->weight.reserve(3*rows);
+    this->offsets.reserve(rows + 1);
+}
+
+void HypothesisPool::add(int vehicle, int lane, State maneuver, float weight) {
+    this->vehicle.push_back(vehicle);
+    this->lane.push_back(lane);
+    this->maneuver.push_back(maneuver);
+    this->weight.push_back(weight);
+}
+
+void HypothesisPool::build(const PredictionStore &predictions, const RoadModel &model) {
+    /*
+    The offset from the lane center plus the drift over LATERAL_LOOKAHEAD, in half widths of
+    the vehicle's own lane, is +-1 at the lane borders. Each change gets a logistic score that passes 1/2 at
+    +-CHANGE_THRESHOLD, keeping the lane scores 1; the scores are normalized over the
+    maneuvers that stay on the road, and light ones are dropped.
+    */
+    this->vehicle.clear();
+    this->lane.clear();
+    this->maneuver.clear();
+    this->weight.clear();
+    this->offsets.resize(predictions.size() + 1);
+
+    int num_lanes = model.num_lanes();
+    for (int i = 0; i < predictions.size(); i++) {
+        this->offsets[i] = size();
+        int lane = predictions.lane(i);
+        if (lane < 0 || lane >= num_lanes) continue;
+        float drift = (predictions.d(i) - model.center(lane) + predictions.d_dot(i)*LATERAL_LOOKAHEAD)/(model.width(lane)/2);
+
+        float keep = 1;
+        float left = lane > 0 ? exp(CHANGE_SHARPNESS*(-drift - CHANGE_THRESHOLD)) : 0;
+        float right = lane + 1 < num_lanes ? exp(CHANGE_SHARPNESS*(drift - CHANGE_THRESHOLD)) : 0;
+        float total = keep + left + right;
+        keep /= total;
+        left = left/total < MIN_WEIGHT ? 0 : left/total;
+        right = right/total < MIN_WEIGHT ? 0 : right/total;
+        total = keep + left + right;
+
+        if (keep/total >= MIN_WEIGHT) add(i, lane, State::KL, keep/total);
+        if (left > 0) add(i, lane - 1, State::LCL, left/total);
+        if (right > 0) add(i, lane + 1, State::LCR, right/total);
+    }
+    this->offsets[predictions.size()] = size();
+}
@@ -0,0 +1,55 @@
+#ifndef HYPOTHESIS_POOL_H
+#define HYPOTHESIS_POOL_H
+#include <vector>
+#include "vehicle.h"
+
+using namespace std;
+
+class PredictionStore;
+class RoadModel;
+
+/*
+ * Weighted maneuver hypotheses of the predicted traffic: every vehicle keeps its lane
+ * (KL) or moves one lane left (LCL) or right (LCR), each with a probability taken from
+ * where the vehicle sits in its lane and how fast it drifts sideways. A vehicle's
+ * weights sum to 1. The hypotheses of all vehicles share one pool of parallel columns,
+ * contiguous per vehicle, rebuilt in place every frame without touching the heap.
+ */
+class HypothesisPool {
+public:
+
+    // one entry per hypothesis
+    vector<int> vehicle; // prediction index
+    vector<int16_t> lane; // lane the vehicle ends up in
+    vector<State> maneuver;
+    vector<float> weight;
+
+    /**
+    * Constructor
+    */
+    HypothesisPool();
+
+    /**
+    * Destructor
+    */
+    virtual ~HypothesisPool();
+
+    // replaces the pool with the hypotheses of every vehicle in predictions
+    void build(const PredictionStore &predictions, const RoadModel &model);
+
+    // makes room for the hypotheses of rows vehicles
+    void reserve(int rows);
+
+    int size() const { return this->vehicle.size(); }
+
+    // hypotheses of prediction i are [first(i), first(i+1))
+    int first(int i) const { return this->offsets[i]; }
+
+private:
+
+    void add(int vehicle, int lane, State maneuver, float weight);
+
+    vector<int> offsets;
+};
+
+#endif
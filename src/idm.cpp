@@ -0,0 +1,180 @@
+#include "idm.h"
+#include <algorithm>
+#include <math.h>
+
+const float FREE_ROAD_GAP = 1e6; // gap given to a vehicle without leader
+
+IdmRollout::IdmRollout() {
+    this->n = 0;
+    this->samples = 0;
+    this->step = 0.1;
+}
+
+IdmRollout::~IdmRollout() {}
+
+static void gap_kernel(const float * __restrict s, const float * __restrict v, int n, float length,
+                       float * __restrict gap, float * __restrict dv) {
+    for (int i = 0; i + 1 < n; i++) {
+        gap[i] = s[i + 1] - s[i] - length;
+        dv[i] = v[i] - v[i + 1];
+    }
+}
+
+static void idm_step_kernel(float * __restrict s, float * __restrict v, const float * __restrict v0,
+                            const float * __restrict gap, const float * __restrict dv, int n,
+                            float dt, const IdmParams &params) {
+    const float a_max = params.max_accel;
+    const float brake = 1/(2*sqrtf(params.max_accel*params.comfort_decel));
+    const float headway = params.time_headway;
+    const float min_gap = params.min_gap;
+    const float max_decel = params.max_decel;
+    for (int i = 0; i < n; i++) {
+        float vi = v[i];
+        float ratio = vi/v0[i];
+        float ratio2 = ratio*ratio;
+        float desired = min_gap + vi*headway + vi*dv[i]*brake;
+        desired = desired > min_gap ? desired : min_gap;
+        float g = gap[i] > 0.1f ? gap[i] : 0.1f;
+        float interaction = desired/g;
+        float a = a_max*(1 - ratio2*ratio2 - interaction*interaction);
+        a = a < -max_decel ? -max_decel : a;
+        float v_next = vi + a*dt;
+        v_next = v_next > 0 ? v_next : 0;
+        s[i] += 0.5f*(vi + v_next)*dt;
+        v[i] = v_next;
+    }
+}
+
+void IdmRollout::reserve(int rows) {
+    int samples = this->samples > 2 ? this->samples : 2;
+    this->s_table.reserve(samples*rows);
+    this->v_table.reserve(samples*rows);
+    this->order_keys.reserve(rows);
+    this->order.reserve(rows);
+    this->sorted_s.reserve(rows);
+    this->sorted_v.reserve(rows);
+    this->desired_v.reserve(rows);
+    this->gap.reserve(rows);
+    this->dv.reserve(rows);
+    this->lane_start.reserve(rows + 1);
+}
+
+void IdmRollout::run(const int *lane, const float *s, const float *v, int n, float horizon, float loop_length,
+                     const IdmParams &params) {
+    /*
+    Vehicles are ordered by (lane, s) through a single sort of packed integer keys. A lane's last
+    vehicle follows the lane's first one a loop further on; a vehicle alone in its lane, or any
+    lane on an open road, drives on a free road.
+    */
+    this->n = n;
+    this->step = params.step > 0 ? params.step : 0.1;
+    this->samples = (int) ceil(horizon/this->step) + 1;
+    if (this->samples < 2) this->samples = 2;
+    this->s_table.resize(this->samples*n);
+    this->v_table.resize(this->samples*n);
+    if (n == 0) return;
+
+    this->order_keys.resize(n);
+    for (int i = 0; i < n; i++) {
+        // lane in the high bits, s in centimeters below, index in the low bits keeps ties stable
+        int64_t lane_key = lane[i] < 0 ? 0 : lane[i] + 1;
+        int64_t s_cm = s[i] > 0 ? (int64_t) (s[i]*100) & 0xFFFFFF : 0;
+        this->order_keys[i] = (lane_key << 44) | (s_cm << 20) | i;
+    }
+    sort(this->order_keys.begin(), this->order_keys.end());
+
+    this->order.resize(n);
+    this->sorted_s.resize(n);
+    this->sorted_v.resize(n);
+    this->desired_v.resize(n);
+    this->gap.resize(n);
+    this->dv.resize(n);
+    this->lane_start.clear();
+    for (int j = 0; j < n; j++) {
+        int i = this->order_keys[j] & 0xFFFFF;
+        this->order[j] = i;
+        this->sorted_s[j] = s[i];
+        this->sorted_v[j] = v[i];
+        this->desired_v[j] = max(v[i], params.min_desired_speed);
+        if (j == 0 || lane[i] != lane[this->order[j - 1]]) this->lane_start.push_back(j);
+        this->s_table[i] = s[i];
+        this->v_table[i] = v[i];
+    }
+    this->lane_start.push_back(n);
+
+    float *ss = this->sorted_s.data();
+    float *sv = this->sorted_v.data();
+    for (int k = 1; k < this->samples; k++) {
+        gap_kernel(ss, sv, n, params.vehicle_length, this->gap.data(), this->dv.data());
+        for (size_t l = 0; l + 1 < this->lane_start.size(); l++) {
+            int first = this->lane_start[l];
+            int last = this->lane_start[l + 1] - 1;
+            if (loop_length > 0 && last > first) {
+                this->gap[last] = ss[first] + loop_length - ss[last] - params.vehicle_length;
+                this->dv[last] = sv[last] - sv[first];
+            } else {
+                this->gap[last] = FREE_ROAD_GAP;
+                this->dv[last] = 0;
+            }
+        }
+        idm_step_kernel(ss, sv, this->desired_v.data(), this->gap.data(), this->dv.data(), n, this->step, params);
+        float *s_row = &this->s_table[k*n];
+        float *v_row = &this->v_table[k*n];
+        for (int j = 0; j < n; j++) {
+            s_row[this->order[j]] = ss[j];
+            v_row[this->order[j]] = sv[j];
+        }
+    }
+}
+
+void IdmRollout::locate(float t, int &row, float &frac, float &overrun) const {
+    float x = t > 0 ? t/this->step : 0;
+    float last = this->samples - 1;
+    overrun = x > last ? (x - last)*this->step : 0;
+    x = x < last ? x : last;
+    row = (int) x;
+    if (row > this->samples - 2) row = this->samples - 2;
+    frac = x - row;
+}
+
+float IdmRollout::s_at(int i, float t) const {
+    int row;
+    float frac, overrun;
+    locate(t, row, frac, overrun);
+    float s0 = this->s_table[row*this->n + i];
+    float s1 = this->s_table[(row + 1)*this->n + i];
+    return s0 + frac*(s1 - s0) + overrun*this->v_table[(this->samples - 1)*this->n + i];
+}
+
+float IdmRollout::v_at(int i, float t) const {
+    int row;
+    float frac, overrun;
+    locate(t, row, frac, overrun);
+    float v0 = this->v_table[row*this->n + i];
+    float v1 = this->v_table[(row + 1)*this->n + i];
+    return v0 + frac*(v1 - v0);
+}
+
+static void lerp_kernel(const float * __restrict s0, const float * __restrict s1, const float * __restrict v_last,
+                        int n, float frac, float overrun, float * __restrict out) {
+    for (int i = 0; i < n; i++) {
+        out[i] = s0[i] + frac*(s1[i] - s0[i]) + overrun*v_last[i];
+    }
+}
+
+void IdmRollout::s_at(float t, float *s_out) const {
+    int row;
+    float frac, overrun;
+    locate(t, row, frac, overrun);
+    lerp_kernel(&this->s_table[row*this->n], &this->s_table[(row + 1)*this->n],
+                &this->v_table[(this->samples - 1)*this->n], this->n, frac, overrun, s_out);
+}
+
+void IdmRollout::v_at(float t, float *v_out) const {
+    int row;
+    float frac, overrun;
+    locate(t, row, frac, overrun);
+    // past the horizon the speed stays at the last sample
+    lerp_kernel(&this->v_table[row*this->n], &this->v_table[(row + 1)*this->n],
+                &this->v_table[(this->samples - 1)*this->n], this->n, frac, 0, v_out);
+}
@@ -0,0 +1,82 @@
+#ifndef IDM_H
+#define IDM_H
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Intelligent Driver Model parameters shared by every predicted vehicle.
+ */
+struct IdmParams {
+    float time_headway = 1.5; // desired time gap to the leader, s
+    float min_gap = 2.0; // bumper to bumper gap kept when stopped, m
+    float max_accel = 1.0; // m/s^2
+    float comfort_decel = 1.5; // m/s^2
+    float max_decel = 9.0; // hardest braking the model may apply, m/s^2
+    float min_desired_speed = 5.0; // a vehicle wants at least this speed, m/s
+    float vehicle_length = 5.0; // m
+    float step = 0.1; // integration step and sample spacing, s
+};
+
+/*
+ * Joint IDM rollout of the predicted traffic. The vehicles are sorted by lane and s
+ * once, so every vehicle's leader is the next one in the sorted arrays; each step is
+ * then a few branch-free loops over contiguous columns (gaps, accelerations,
+ * integration) plus one fix-up per lane for the lane leader, which follows the last
+ * vehicle of its lane around the loop. Every vehicle wants to keep its current speed
+ * (at least min_desired_speed) and lane. Positions and speeds are sampled every step
+ * and stored step-major, so evaluating all vehicles at one time reads two rows.
+ */
+class IdmRollout {
+public:
+
+    /**
+    * Constructor
+    */
+    IdmRollout();
+
+    /**
+    * Destructor
+    */
+    virtual ~IdmRollout();
+
+    // simulates n vehicles for horizon seconds; loop_length > 0 closes each lane into a loop
+    void run(const int *lane, const float *s, const float *v, int n, float horizon, float loop_length,
+             const IdmParams &params);
+
+    // makes room for rows vehicles over the sample count of the last run
+    void reserve(int rows);
+
+    void clear() { this->n = 0; this->samples = 0; }
+
+    bool empty() const { return this->samples == 0; }
+
+    int size() const { return this->n; }
+
+    // position and speed of vehicle i (in the order given to run) t seconds from now
+    float s_at(int i, float t) const;
+    float v_at(int i, float t) const;
+
+    // positions and speeds of every vehicle t seconds from now, size() values
+    void s_at(float t, float *s_out) const;
+    void v_at(float t, float *v_out) const;
+
+private:
+
+    // sample row below t, interpolation weight and time past the last sample
+    void locate(float t, int &row, float &frac, float &overrun) const;
+
+    int n;
+    int samples;
+    float step;
+    vector<float> s_table; // samples x n, in run order
+    vector<float> v_table;
+    // scratch of the rollout, in lane-sorted order
+    vector<int64_t> order_keys;
+    vector<int> order;
+    vector<float> sorted_s, sorted_v, desired_v, gap, dv;
+    vector<int> lane_start;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include "jmt_solver.h"
+#include <algorithm>
+
+void jmt_inverse(double T, double *inverse) {
+    double T2 = T*T;
+    double T3 = T2*T;
+    double T4 = T3*T;
+    double T5 = T4*T;
+    inverse[0] = 10/T3;
+    inverse[1] = -4/T2;
+    inverse[2] = 0.5/T;
+    inverse[3] = -15/T4;
+    inverse[4] = 7/T3;
+    inverse[5] = -1/T2;
+    inverse[6] = 6/T5;
+    inverse[7] = -3/T4;
+    inverse[8] = 0.5/T3;
+}
+
+static void jmt_kernel(double m0, double m1, double m2, double m3, double m4, double m5, double m6, double m7, double m8,
+                       double p_free, double v_free, double a0,
+                       const double * __restrict end_p, const double * __restrict end_v, const double * __restrict end_a, int n,
+                       double * __restrict c3, double * __restrict c4, double * __restrict c5) {
+    for (int i = 0; i < n; i++) {
+        // what the quintic must add to the free motion of the start state
+        double b0 = end_p[i] - p_free;
+        double b1 = end_v[i] - v_free;
+        double b2 = end_a[i] - a0;
+        c3[i] = m0*b0 + m1*b1 + m2*b2;
+        c4[i] = m3*b0 + m4*b1 + m5*b2;
+        c5[i] = m6*b0 + m7*b1 + m8*b2;
+    }
+}
+
+JmtSolver::JmtSolver() {}
+
+JmtSolver::~JmtSolver() {}
+
+void JmtSolver::set_durations(const float *durations, int n) {
+    if ((int) this->T.size() == n && equal(this->T.begin(), this->T.end(), durations)) return;
+    this->T.assign(durations, durations + n);
+    this->inverses.resize(9*n);
+    for (int k = 0; k < n; k++) {
+        jmt_inverse(durations[k], &this->inverses[9*k]);
+    }
+}
+
+void JmtSolver::solve(int k, const double *start, const double *end_p, const double *end_v, const double *end_a, int n,
+                      double *const *coef) const {
+    double T = this->T[k];
+    const double *m = &this->inverses[9*k];
+    for (int i = 0; i < n; i++) {
+        coef[0][i] = start[0];
+        coef[1][i] = start[1];
+        coef[2][i] = 0.5*start[2];
+    }
+    jmt_kernel(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8],
+               start[0] + start[1]*T + 0.5*start[2]*T*T, start[1] + start[2]*T, start[2],
+               end_p, end_v, end_a, n, coef[3], coef[4], coef[5]);
+}
@@ -0,0 +1,56 @@
+#ifndef JMT_SOLVER_H
+#define JMT_SOLVER_H
+#include <vector>
+
+using namespace std;
+
+/*
+ * Closed-form inverse of the matrix mapping the coefficients a3, a4, a5 of a
+ * quintic to its position, speed and acceleration at t = T, row-major:
+ *   | T^3   T^4    T^5   |-1     |  10/T^3  -4/T^2   1/(2T)   |
+ *   | 3T^2  4T^3   5T^4  |    =  | -15/T^4   7/T^3  -1/T^2    |
+ *   | 6T    12T^2  20T^3 |       |   6/T^5  -3/T^4   1/(2T^3) |
+ */
+void jmt_inverse(double T, double *inverse);
+
+/*
+ * Batched jerk-minimizing trajectory solver. The inverse above is cached once
+ * per duration; a batch of n end states sharing one start state and one duration
+ * is then solved as a single 3x3 by 3xn matrix product, written straight into the
+ * caller's coefficient columns without touching the heap.
+ */
+class JmtSolver {
+public:
+
+    /**
+    * Constructor
+    */
+    JmtSolver();
+
+    /**
+    * Destructor
+    */
+    virtual ~JmtSolver();
+
+    // caches the inverse for each of the n durations; keeps the cache if they did not change
+    void set_durations(const float *durations, int n);
+
+    int durations() const { return this->T.size(); }
+
+    float duration(int k) const { return this->T[k]; }
+
+    /*
+     * Quintics of duration(k) from start (position, speed, acceleration) to the n end
+     * states (end_p[i], end_v[i], end_a[i]). coef[j] receives the t^j coefficient of
+     * every row, lowest order first.
+     */
+    void solve(int k, const double *start, const double *end_p, const double *end_v, const double *end_a, int n,
+               double *const *coef) const;
+
+private:
+
+    vector<float> T;
+    vector<double> inverses; // 9 per duration, row-major
+};
+
+#endif
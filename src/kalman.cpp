@@ -0,0 +1,119 @@
+#include "kalman.h"
+
+// floor through an integer conversion, so the kernels vectorize without libm calls
+static inline float floor_fast(float v) {
+    float t = (float) (int) v;
+    return t > v ? t - 1 : t;
+}
+
+static inline float wrap_position(float x, float wrap) {
+    return wrap > 0 ? x - wrap*floor_fast(x/wrap) : x;
+}
+
+static inline float wrap_innovation(float y, float wrap) {
+    return wrap > 0 ? y - wrap*floor_fast(y/wrap + 0.5f) : y;
+}
+
+void KalmanBank::resize(int n) {
+    this->x0.resize(n, 0);
+    this->x1.resize(n, 0);
+    this->x2.resize(n, 0);
+    this->p00.resize(n, 0);
+    this->p01.resize(n, 0);
+    this->p02.resize(n, 0);
+    this->p11.resize(n, 0);
+    this->p12.resize(n, 0);
+    this->p22.resize(n, 0);
+}
+
+void KalmanBank::init(int i, float pos, float vel, float var_pos, float var_vel, float var_acc) {
+    this->x0[i] = pos;
+    this->x1[i] = vel;
+    this->x2[i] = 0;
+    this->p00[i] = var_pos;
+    this->p01[i] = 0;
+    this->p02[i] = 0;
+    this->p11[i] = var_vel;
+    this->p12[i] = 0;
+    this->p22[i] = var_acc;
+}
+
+void kalman_predict(KalmanBank &bank, float dt, float q) {
+    const int n = bank.size();
+    const float a = dt;
+    const float b = 0.5f*dt*dt;
+    const float q00 = q*dt*dt*dt*dt*dt/20, q01 = q*dt*dt*dt*dt/8, q02 = q*dt*dt*dt/6;
+    const float q11 = q*dt*dt*dt/3, q12 = q*dt*dt/2, q22 = q*dt;
+    float * __restrict x0 = bank.x0.data();
+    float * __restrict x1 = bank.x1.data();
+    float * __restrict x2 = bank.x2.data();
+    float * __restrict p00 = bank.p00.data();
+    float * __restrict p01 = bank.p01.data();
+    float * __restrict p02 = bank.p02.data();
+    float * __restrict p11 = bank.p11.data();
+    float * __restrict p12 = bank.p12.data();
+    float * __restrict p22 = bank.p22.data();
+    for (int i = 0; i < n; i++) {
+        x0[i] = x0[i] + a*x1[i] + b*x2[i];
+        x1[i] = x1[i] + a*x2[i];
+        // rows of F*P, then (F*P)*F'
+        float r00 = p00[i] + a*p01[i] + b*p02[i];
+        float r01 = p01[i] + a*p11[i] + b*p12[i];
+        float r02 = p02[i] + a*p12[i] + b*p22[i];
+        float r11 = p11[i] + a*p12[i];
+        float r12 = p12[i] + a*p22[i];
+        p00[i] = r00 + a*r01 + b*r02 + q00;
+        p01[i] = r01 + a*r02 + q01;
+        p02[i] = r02 + q02;
+        p11[i] = r11 + a*r12 + q11;
+        p12[i] = r12 + q12;
+        p22[i] = p22[i] + q22;
+    }
+}
+
+void kalman_update_pos_vel(KalmanBank &bank, const float *z_pos, const float *z_vel, const float *mask,
+                           float r_pos, float r_vel, float wrap) {
+    const int n = bank.size();
+    float * __restrict x0 = bank.x0.data();
+    float * __restrict x1 = bank.x1.data();
+    float * __restrict x2 = bank.x2.data();
+    float * __restrict p00 = bank.p00.data();
+    float * __restrict p01 = bank.p01.data();
+    float * __restrict p02 = bank.p02.data();
+    float * __restrict p11 = bank.p11.data();
+    float * __restrict p12 = bank.p12.data();
+    float * __restrict p22 = bank.p22.data();
+    for (int i = 0; i < n; i++) {
+        // S = H P H' + R and its closed-form inverse, K = P H' S^-1
+        float s00 = p00[i] + r_pos;
+        float s01 = p01[i];
+        float s11 = p11[i] + r_vel;
+        float inv_det = mask[i]/(s00*s11 - s01*s01);
+        float k00 = (p00[i]*s11 - p01[i]*s01)*inv_det;
+        float k01 = (p01[i]*s00 - p00[i]*s01)*inv_det;
+        float k10 = (p01[i]*s11 - p11[i]*s01)*inv_det;
+        float k11 = (p11[i]*s00 - p01[i]*s01)*inv_det;
+        float k20 = (p02[i]*s11 - p12[i]*s01)*inv_det;
+        float k21 = (p12[i]*s00 - p02[i]*s01)*inv_det;
+
+        float y0 = wrap_innovation(z_pos[i] - x0[i], wrap);
+        float y1 = z_vel[i] - x1[i];
+        x0[i] = wrap_position(x0[i] + k00*y0 + k01*y1, wrap);
+        x1[i] = x1[i] + k10*y0 + k11*y1;
+        x2[i] = x2[i] + k20*y0 + k21*y1;
+
+        // P = P - K H P
+        float n00 = p00[i] - (k00*p00[i] + k01*p01[i]);
+        float n01 = p01[i] - (k00*p01[i] + k01*p11[i]);
+        float n02 = p02[i] - (k00*p02[i] + k01*p12[i]);
+        float n11 = p11[i] - (k10*p01[i] + k11*p11[i]);
+        float n12 = p12[i] - (k10*p02[i] + k11*p12[i]);
+        float n22 = p22[i] - (k20*p02[i] + k21*p12[i]);
+        p00[i] = n00;
+        p01[i] = n01;
+        p02[i] = n02;
+        p11[i] = n11;
+        p12[i] = n12;
+        p22[i] = n22;
+    }
+}
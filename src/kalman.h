@@ -0,0 +1,37 @@
+#ifndef KALMAN_H
+#define KALMAN_H
+#include <vector>
+
+using namespace std;
+
+/*
+ * A bank of independent constant-acceleration Kalman filters along one Frenet axis,
+ * stored as structure of arrays: state (position, velocity, acceleration) and the six
+ * distinct entries of the symmetric 3x3 covariance. The kernels below run one step for
+ * every filter of the bank in a single branch-free loop that the compiler vectorizes.
+ */
+struct KalmanBank {
+    vector<float> x0, x1, x2; // position, velocity, acceleration
+    vector<float> p00, p01, p02, p11, p12, p22;
+
+    int size() const { return this->x0.size(); }
+
+    // grows the bank to n filters, keeping existing ones
+    void resize(int n);
+
+    // restarts filter i at a known position and velocity
+    void init(int i, float pos, float vel, float var_pos, float var_vel, float var_acc);
+};
+
+// x = F x, P = F P F' + Q for a white-jerk process of spectral density q
+void kalman_predict(KalmanBank &bank, float dt, float q);
+
+/*
+ * Measurement update with position and velocity. Filters with mask 0 are left untouched.
+ * With wrap > 0 positions live on a loop of that length: innovations take the short
+ * way round and the estimate is kept in [0, wrap).
+ */
+void kalman_update_pos_vel(KalmanBank &bank, const float *z_pos, const float *z_vel, const float *mask,
+                           float r_pos, float r_vel, float wrap);
+
+#endif
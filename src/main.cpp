@@ -12,6 +12,9 @@
 #include "Eigen-3.3/Eigen/QR"
 #include "road.h"
 #include "vehicle.h"
+#include "flight_recorder.h"
+#include "profiler.h"
+#include "thread_pool.h"
 #include <algorithm>
 
 
@@ -140,7 +143,7 @@ vector<double> getFrenet(double x, double y, double theta, const vector<double>
 
 }
 // Transform from Frenet s,d coordinates to Cartesian x,y
-vector<double> getXY(double s, double d, const vector<double> &maps_s, const vector<double> &maps_x, const vector<double> &maps_y)
+frame_vector<double> getXY(double s, double d, const vector<double> &maps_s, const vector<double> &maps_x, const vector<double> &maps_y)
 {
 	int prev_wp = -1;
 
@@ -171,17 +174,25 @@ vector<double> getXY(double s, double d, const vector<double> &maps_s, const vec
 //Init road parameters
 double REF_VEL=49.0;
 double GOAL_S=6945.554;
-vector<float> LANE_SPEEDS = {REF_VEL,REF_VEL,REF_VEL};
-int LANE_WIDTH=4;
+int NUM_LANES=3; //default layout, used when the lane file is missing
+float LANE_WIDTH=4;
 int MAX_ACCEL = 1;
 float TIME_HORIZON=2;
 float MPH_CONVERT=0.447;
-int NUM_LANES = LANE_SPEEDS.size();
 double acc=0;
 int TARGET_LANE=1;//the lane we want to reach after each new manoeuvre
-int car_state=0;//0=="KL",1=="LCR",-1=="LCL"
-Road road = Road(REF_VEL, LANE_SPEEDS,LANE_WIDTH,TIME_HORIZON,MPH_CONVERT);
+int car_state=(int) State::KL;//behavior state carried over to the next message
+int SENT_PATH_SIZE=0;//points sent in the last control message
+double POINT_DT=0.02;//the simulator consumes one path point every 20ms
+Road road = Road(RoadModel(NUM_LANES,LANE_WIDTH,REF_VEL*MPH_CONVERT),TIME_HORIZON);
 vector<float> ego_config = {REF_VEL*MPH_CONVERT,NUM_LANES,GOAL_S,MAX_ACCEL};
+//Flight recorder: last RECORDER_FRAMES planning cycles, kept in a memory-mapped file
+string RECORDER_FILE="flight_recorder.bin";
+int RECORDER_FRAMES=4096;
+FlightRecorder recorder;
+//Limit checks of every emitted path
+FeasibilityChecker path_checker;
+uint64_t INFEASIBLE_PATHS=0;
 
 
 int main() {
@@ -196,6 +207,8 @@ int main() {
 
   // Waypoint map to read from
   string map_file_ = "../data/highway_map.csv";
+  // Lane widths and speed limits (MPH) of the road
+  string lanes_file_ = "../data/highway_lanes.txt";
 
 
   ifstream in_map_(map_file_.c_str(), ifstream::in);
@@ -219,7 +232,36 @@ int main() {
   	map_waypoints_dx.push_back(d_x);
   	map_waypoints_dy.push_back(d_y);
   }
-  road.add_ego2(1,0,6,0,0,0,1,ego_config);
+  road.frenet.build(map_waypoints_s,map_waypoints_x,map_waypoints_y,map_waypoints_dx,map_waypoints_dy,GOAL_S);
+  if(!road.model.load(lanes_file_,MPH_CONVERT)){
+    std::cerr << "Could not read " << lanes_file_ << ", using " << NUM_LANES << " lanes of " << LANE_WIDTH << " m" << std::endl;
+  }
+  ego_config[0]=road.model.max_speed_limit();
+  ego_config[1]=road.model.num_lanes();
+  road.add_ego2(1,0,road.model.center(1),0,0,car_state,1,ego_config.data());
+  const char *trace_file=getenv("PATH_PLANNING_TRACE");
+  if(trace_file!=NULL && tracer.open(trace_file)){
+    tracer.set_thread_name("event loop");
+    std::cout << "Writing trace events to " << trace_file << std::endl;
+  }
+  if(getenv("PATH_PLANNING_PERF_COUNTERS")!=NULL && !profiler.enable_counters()){
+    std::cerr << "Hardware performance counters unavailable (perf_event_open failed)" << std::endl;
+  }
+  const char *sample_candidates=getenv("PATH_PLANNING_CANDIDATES");
+  if(sample_candidates!=NULL && atoi(sample_candidates)==0){
+    road.sample_candidates=false;
+    std::cout << "Deciding with the behavior FSM only, without trajectory candidates" << std::endl;
+  }
+  const char *planner_threads=getenv("PATH_PLANNING_THREADS");
+  if(planner_threads!=NULL && atoi(planner_threads)>1){
+    planner_pool.start(atoi(planner_threads));
+    std::cout << "Evaluating behavior candidates on " << planner_pool.size() << " threads" << std::endl;
+  }
+  if(recorder.open(RECORDER_FILE,RECORDER_FRAMES)){
+    recorder.install_signal_handlers();
+  }else{
+    std::cerr << "Flight recorder disabled: cannot map " << RECORDER_FILE << std::endl;
+  }
   h.onMessage([&map_waypoints_x,&map_waypoints_y,&map_waypoints_s,&map_waypoints_dx,&map_waypoints_dy](uWS::WebSocket<uWS::SERVER> ws, char *data, size_t length,
                      uWS::OpCode opCode) {
     // "42" at the start of the message means there's a websocket message event.
@@ -238,6 +280,8 @@ int main() {
         string event = j[0].get<string>();
         
         if (event == "telemetry") {
+          StageScope frame(STAGE_FRAME);
+          frame_arena.reset();
           // j[1] is the data JSON object
           	json msgJson;
 
@@ -255,21 +299,21 @@ int main() {
           	double end_path_s = j[1]["end_path_s"];
           	double end_path_d = j[1]["end_path_d"];
           	vector<vector<double>> sensor_fusion = j[1]["sensor_fusion"];
-          	vector<double> next_x_vals;
-          	vector<double> next_y_vals;
+          	frame_vector<double> next_x_vals;
+          	frame_vector<double> next_y_vals;
 
           	/////Update car state: s position, d position, lane, speed,acceleration,
           	vector<double> car_data={car_x,car_y,car_s,car_d,speed*MPH_CONVERT,acc,car_state,TARGET_LANE};
-          	road.populate_traffic2(sensor_fusion,car_data); //add visible cars including ego
+          	//simulated time since the last message, from the number of path points consumed
+          	double frame_dt=max(0,SENT_PATH_SIZE-(int)previous_path_x.size())*POINT_DT;
+          	road.populate_traffic2(sensor_fusion,car_data,frame_dt); //add visible cars including ego
           	road.advance();
           	Vehicle new_pos=road.get_ego();
           	double new_s=new_pos.s; //updated s position
           	double new_d=new_pos.d; //updated lane
           	double new_v_s=new_pos.v_s; //updated speed
           	acc=new_pos.a_s; //updated acceleration
-          	if(new_pos.state=="KL")car_state=0;
-          	if(new_pos.state=="LCR")car_state=1;
-          	if(new_pos.state=="LCL")car_state=-1;
+          	car_state=(int) new_pos.state;
           	if(new_v_s>0){ // Speed update
           		REF_VEL=new_v_s/MPH_CONVERT;
           	}
@@ -305,9 +349,9 @@ int main() {
           		ptsy.push_back(ref_y);
           	}
 
-          	vector<double> next_wp0;
-          	vector<double> next_wp1;
-          	vector<double> next_wp2;
+          	frame_vector<double> next_wp0;
+          	frame_vector<double> next_wp1;
+          	frame_vector<double> next_wp2;
           	next_wp0=getXY(car_s+60,new_d,map_waypoints_s,map_waypoints_x,map_waypoints_y);
           	next_wp1=getXY(car_s+80,new_d,map_waypoints_s,map_waypoints_x,map_waypoints_y);
           	next_wp2=getXY(car_s+90,new_d,map_waypoints_s,map_waypoints_x,map_waypoints_y);
@@ -332,13 +376,18 @@ int main() {
           	}
 
           	tk::spline s;
-          	s.set_points(ptsx,ptsy);
+          	{
+          		StageScope stage(STAGE_SPLINE_BUILD);
+          		s.set_points(ptsx,ptsy);
+          	}
 
           	double target_x=30.0;
           	double target_y=s(target_x);
           	double target_dist=sqrt(target_x*target_x+target_y*target_y);
           	double x_add_on=0;
 
+          	{
+          	StageScope stage(STAGE_SPLINE_SAMPLE);
             for(int i=1;i<=50-previous_path_x.size();i++){
           		double N=target_dist/(0.02*REF_VEL*MPH_CONVERT);
           		double x_point=x_add_on+target_x/N;
@@ -353,16 +402,28 @@ int main() {
           		next_x_vals.push_back(x_point);
           		next_y_vals.push_back(y_point);
           	}
+          	}
           	// TODO: define a path made up of (x,y) points that the car will visit sequentially every .02 seconds
 
-          	msgJson["next_x"] = next_x_vals;
-          	msgJson["next_y"] = next_y_vals;
-          	auto msg = "42[\"control\","+ msgJson.dump()+"]";
+          	path_checker.check_sampled(next_x_vals.data(),next_y_vals.data(),next_x_vals.size(),1,road.limits);
+          	INFEASIBLE_PATHS+=!path_checker.feasible[0];
+
+          	recorder.record(road,next_x_vals,next_y_vals);
+          	SENT_PATH_SIZE=next_x_vals.size();
+
+          	string msg;
+          	{
+          		StageScope stage(STAGE_SERIALIZE);
+          		msgJson["next_x"] = next_x_vals;
+          		msgJson["next_y"] = next_y_vals;
+          		msg = "42[\"control\","+ msgJson.dump()+"]";
+          	}
 
           	//this_thread::sleep_for(chrono::milliseconds(1000));
           	ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
           
         }
+        tracer.flush();
       } else {
         // Manual driving
         std::string msg = "42[\"manual\",{}]";
@@ -371,13 +432,31 @@ int main() {
     }
   });
 
-  // We don't need this since we're not using HTTP but if it's removed the
-  // program
-  // doesn't compile :-(
+  // Plain HTTP on the same port: GET /metrics returns the per-stage planner
+  // statistics in Prometheus text format.
   h.onHttpRequest([](uWS::HttpResponse *res, uWS::HttpRequest req, char *data,
                      size_t, size_t) {
     const std::string s = "<h1>Hello world!</h1>";
-    if (req.getUrl().valueLength == 1) {
+    std::string url(req.getUrl().value, req.getUrl().valueLength);
+    if (url == "/metrics") {
+      std::ostringstream road_metrics;
+      road_metrics << "path_planning_vehicles_culled_total " << road.vehicles_culled_total << "\n";
+      road_metrics << "path_planning_vehicles_in_range " << road.traffic.size() << "\n";
+      road_metrics << "path_planning_infeasible_paths_total " << INFEASIBLE_PATHS << "\n";
+      if (path_checker.size() > 0) {
+        road_metrics << "path_planning_path_max_speed " << path_checker.max_speed[0] << "\n";
+        road_metrics << "path_planning_path_max_accel " << path_checker.max_accel[0] << "\n";
+        road_metrics << "path_planning_path_max_jerk " << path_checker.max_jerk[0] << "\n";
+        road_metrics << "path_planning_path_max_curvature " << path_checker.max_curvature[0] << "\n";
+      }
+      if (road.sample_candidates) {
+        road_metrics << "path_planning_feasible_candidates " << road.feasibility.count_feasible() << "\n";
+        road_metrics << "path_planning_colliding_candidates " << road.collisions.count_collisions() << "\n";
+        road_metrics << "path_planning_clear_candidates " << count(road.candidate_clear.begin(), road.candidate_clear.end(), 1) << "\n";
+      }
+      const std::string metrics = profiler.metrics() + road_metrics.str();
+      res->end(metrics.data(), metrics.length());
+    } else if (req.getUrl().valueLength == 1) {
       res->end(s.data(), s.length());
     } else {
       // i guess this should be done more gracefully?
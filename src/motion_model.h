@@ -0,0 +1,65 @@
+#ifndef MOTION_MODEL_H
+#define MOTION_MODEL_H
+#include <stdint.h>
+
+/*
+ * Closed-form motion of a predicted vehicle: where it is at any time t from now.
+ * A descriptor is a handful of floats, so predictions cost no storage per time
+ * step and can be evaluated at whatever resolution a check needs. The free
+ * functions are branch free and meant to be called from loops over many vehicles.
+ */
+
+enum MotionType : uint8_t {
+    MOTION_CONSTANT_VELOCITY = 0, // a is ignored
+    MOTION_CONSTANT_ACCELERATION, // brakes to a stop, never reverses
+    MOTION_IDM, // sampled from the joint IDM rollout (idm.h); the descriptor only holds the state at t=0
+};
+
+struct MotionModel {
+    float s0; // s at t=0
+    float v; // speed along s at t=0
+    float a; // acceleration along s
+    float d; // d at t=0
+    float d_dot; // lateral speed
+    int16_t lane; // lane at t=0
+    MotionType type;
+};
+
+// time actually spent moving within t: a braking vehicle stops at -v/a
+inline float motion_moving_time(float v, float a, float t) {
+    float brake = a < 0 ? a : -1.0f; // keeps the division unconditional
+    float t_stop = a < 0 ? -v/brake : t;
+    return t_stop < t ? t_stop : t;
+}
+
+inline float motion_s_at(float s0, float v, float a, float t) {
+    float tm = motion_moving_time(v, a, t);
+    return s0 + v*tm + 0.5f*a*tm*tm;
+}
+
+inline float motion_v_at(float v, float a, float t) {
+    return v + a*motion_moving_time(v, a, t);
+}
+
+inline float motion_d_at(float d, float d_dot, float t) {
+    return d + d_dot*t;
+}
+
+// acceleration the model actually applies
+inline float motion_acceleration(const MotionModel &model) {
+    return model.type == MOTION_CONSTANT_VELOCITY ? 0 : model.a;
+}
+
+inline float motion_s_at(const MotionModel &model, float t) {
+    return motion_s_at(model.s0, model.v, motion_acceleration(model), t);
+}
+
+inline float motion_v_at(const MotionModel &model, float t) {
+    return motion_v_at(model.v, motion_acceleration(model), t);
+}
+
+inline float motion_d_at(const MotionModel &model, float t) {
+    return motion_d_at(model.d, model.d_dot, t);
+}
+
+#endif
@@ -0,0 +1,76 @@
+#include <iostream>
+#include "prediction_store.h"
+
+using namespace std;
+
+/*
+ * Checks the neighbour index lookups where the looping track wraps around: at
+ * GOAL_S the track starts again at s = 0. Prints every failed lookup and exits
+ * with code 1 if there is one.
+ * Usage: neighbour_check
+ */
+
+double GOAL_S=6945.554;
+int NUM_LANES=3;
+float LANE_WIDTH=4;
+float SPEED_LIMIT=22;
+
+int failures = 0;
+
+void check(const char *what, int index, int expected) {
+    if (index != expected) {
+        cout << what << ": got " << index << ", expected " << expected << endl;
+        failures++;
+    }
+}
+
+int main() {
+    RoadModel model(NUM_LANES, LANE_WIDTH, SPEED_LIMIT);
+    PredictionStore predictions;
+    MotionModel motion;
+    motion.type = MOTION_CONSTANT_VELOCITY;
+    motion.v = 20;
+    motion.a = 0;
+    motion.d_dot = 0;
+    // 0: lane 1, just past the seam
+    motion.s0 = 5;
+    motion.d = model.center(1);
+    motion.lane = 1;
+    predictions.add(10, motion);
+    // 1: lane 0, just before the seam
+    motion.s0 = 6935;
+    motion.d = model.center(0);
+    motion.lane = 0;
+    predictions.add(11, motion);
+    // 2: lane 0, turning towards lane 1: only its heading takes its footprint over the lane line
+    motion.s0 = 6942;
+    motion.d = 2.6;
+    motion.d_dot = 5;
+    motion.lane = 0;
+    predictions.add(12, motion);
+    predictions.build_index(NUM_LANES, GOAL_S);
+    const NeighbourIndex &index = predictions.neighbours();
+
+    // lookups ahead across GOAL_S
+    check("ahead in lane 1 from 6943, across the seam", index.nearest_ahead(1, 6943, 4, 8, 30), 0);
+    check("ahead in lane 2 from 6943, nothing within range", index.nearest_ahead(2, 6943, 8, 12, 30), -1);
+    check("ahead in lane 0 from 100, past the last vehicle", index.nearest_ahead(0, 100, 0, 4, 30), -1);
+
+    // lookups behind right after the ego crosses the seam
+    check("behind in lane 0 from 3, across the seam", index.nearest_behind(0, 3), 2);
+    check("behind in lane 1 from 100", index.nearest_behind(1, 100), 0);
+
+    // a vehicle more than half a loop back is ahead, not behind
+    check("behind in lane 1 from 4000, more than half a loop back", index.nearest_behind(1, 4000), -1);
+
+    // footprints reaching into the lane from the lane next to it
+    check("ahead in lane 1 from 6940, footprint from lane 0", index.nearest_ahead(1, 6940, 4, 8, 30), 2);
+    check("ahead in lane 1 from 6930, centered in lane 0", index.nearest_ahead(1, 6930, 4, 8, 30), 2);
+
+    if (failures > 0) {
+        cout << failures << " neighbour index lookups failed" << endl;
+        return 1;
+    }
+    cout << "neighbour index lookups passed" << endl;
+    return 0;
+}
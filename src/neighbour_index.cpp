@@ -0,0 +1,90 @@
+#include "neighbour_index.h"
+#include "prediction_store.h"
+#include <algorithm>
+#include <math.h>
+
+NeighbourIndex::NeighbourIndex() {
+    this->num_lanes = 0;
+    this->loop_length = 0;
+}
+
+NeighbourIndex::~NeighbourIndex() {}
+
+void NeighbourIndex::build(const PredictionStore &predictions, int num_lanes, float loop_length) {
+    /*
+    The end circles of a footprint sit offset along the heading, whose sine against the road is
+    d_dot over the speed, so they reach that much further to the side than the middle one.
+    */
+    this->num_lanes = num_lanes;
+    this->loop_length = loop_length;
+    float offset = this->footprint.offset(FOOTPRINT_CIRCLES - 1);
+    float radius = this->footprint.radius();
+    if ((int) this->lanes.size() < num_lanes) this->lanes.resize(num_lanes);
+    for (int lane = 0; lane < num_lanes; lane++) {
+        this->lanes[lane].clear();
+    }
+    for (int i = 0; i < predictions.size(); i++) {
+        int lane = predictions.lane(i);
+        if (lane < 0 || lane >= num_lanes) continue;
+        float v = predictions.model(i).v;
+        float d_dot = predictions.d_dot(i);
+        float sine = fabs(d_dot)/sqrt(v*v + d_dot*d_dot + 1e-6f);
+        float half = offset*sine + radius;
+        Entry entry = {predictions.s(i), predictions.d(i) - half, predictions.d(i) + half, i};
+        this->lanes[lane].push_back(entry);
+    }
+    for (int lane = 0; lane < num_lanes; lane++) {
+        sort(this->lanes[lane].begin(), this->lanes[lane].end(), by_s_index);
+    }
+}
+
+void NeighbourIndex::reserve(int rows, int num_lanes) {
+    if ((int) this->lanes.size() < num_lanes) this->lanes.resize(num_lanes);
+    for (size_t lane = 0; lane < this->lanes.size(); lane++) {
+        this->lanes[lane].reserve(rows);
+    }
+}
+
+int NeighbourIndex::nearest_ahead(int lane, float s, float d_min, float d_max, float range) const {
+    /*
+    Every bucket is walked on from the first vehicle past s, in order of distance ahead, until a
+    footprint reaches into the span or the distance passes the best one so far. In lane itself the
+    first vehicle always does. On a loop the walk goes on from the start of the bucket a loop further.
+    */
+    int best = -1;
+    float best_ds = this->loop_length > 0 ? min(range, 0.5f*this->loop_length) : range;
+    for (int l = max(lane - 1, 0); l <= min(lane + 1, this->num_lanes - 1); l++) {
+        const vector<Entry> &bucket = this->lanes[l];
+        int n = bucket.size();
+        Entry key = {s, 0, 0, 0};
+        int first = upper_bound(bucket.begin(), bucket.end(), key, by_s) - bucket.begin();
+        for (int k = first; k < first + n; k++) {
+            if (k >= n && this->loop_length <= 0) break;
+            const Entry &entry = bucket[k < n ? k : k - n];
+            float ds = k < n ? entry.s - s : entry.s - s + this->loop_length;
+            if (ds > best_ds) break;
+            if (entry.d_max <= d_min || entry.d_min >= d_max) continue;
+            if (ds < best_ds || entry.index < best) {
+                best = entry.index;
+                best_ds = ds;
+            }
+            break;
+        }
+    }
+    return best;
+}
+
+int NeighbourIndex::nearest_behind(int lane, float s) const {
+    if (lane < 0 || lane >= this->num_lanes) return -1;
+    const vector<Entry> &bucket = this->lanes[lane];
+    Entry key = {s, 0, 0, 0};
+    vector<Entry>::const_iterator it = lower_bound(bucket.begin(), bucket.end(), key, by_s);
+    // on a loop, behind means behind the short way round; further back is ahead
+    float half_loop = this->loop_length > 0 ? 0.5f*this->loop_length : INFINITY;
+    if (it != bucket.begin() && s - (it - 1)->s < half_loop) return (it - 1)->index;
+    // otherwise the last vehicle of the lane may be just behind, a loop back
+    if (this->loop_length > 0 && !bucket.empty() && s - bucket.back().s + this->loop_length < half_loop) {
+        return bucket.back().index;
+    }
+    return -1;
+}
@@ -0,0 +1,68 @@
+#ifndef NEIGHBOUR_INDEX_H
+#define NEIGHBOUR_INDEX_H
+#include <vector>
+#include "footprint_table.h"
+
+using namespace std;
+
+class PredictionStore;
+
+/*
+ * Per-frame lane-bucketed index of the predicted traffic: for every lane, the
+ * vehicles' current s sorted ascending, with the lateral extent of their
+ * footprints. Nearest-ahead and nearest-behind queries are binary searches and
+ * always return the truly nearest vehicle. On a loop they measure the short way
+ * round, across the end of the track, as Road::cull does.
+ */
+class NeighbourIndex {
+public:
+
+    Footprint footprint; // of every vehicle
+
+    /**
+    * Constructor
+    */
+    NeighbourIndex();
+
+    /**
+    * Destructor
+    */
+    virtual ~NeighbourIndex();
+
+    // rebuilds the buckets from the current position of every prediction on a loop of loop_length (0 for an open road), keeping their capacity
+    void build(const PredictionStore &predictions, int num_lanes, float loop_length);
+
+    // makes room for rows vehicles in every lane
+    void reserve(int rows, int num_lanes);
+
+    /*
+     * Prediction index of the closest vehicle less than range (and half a loop) ahead of s whose footprint
+     * reaches into (d_min, d_max), the span of lane, now; -1 if none. Equal s go to the
+     * lowest index. A footprint is narrower than a lane, so only the vehicles of lane and
+     * of the lanes next to it are looked at.
+     */
+    int nearest_ahead(int lane, float s, float d_min, float d_max, float range) const;
+
+    // prediction index of the closest vehicle in lane behind s (strictly, and less than half a loop back), -1 if none
+    int nearest_behind(int lane, float s) const;
+
+private:
+
+    struct Entry {
+        float s;
+        float d_min; // lateral extent of the footprint
+        float d_max;
+        int index;
+    };
+
+    static bool by_s(const Entry &a, const Entry &b) { return a.s < b.s; }
+
+    // total order, so equal s keep prediction order without a stable sort
+    static bool by_s_index(const Entry &a, const Entry &b) { return a.s < b.s || (a.s == b.s && a.index < b.index); }
+
+    int num_lanes;
+    float loop_length;
+    vector<vector<Entry>> lanes;
+};
+
+#endif
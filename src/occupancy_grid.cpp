@@ -0,0 +1,142 @@
+#include "occupancy_grid.h"
+#include "prediction_store.h"
+#include "frame_arena.h"
+#include <algorithm>
+#include <math.h>
+
+static void position_kernel(const double * __restrict s0, const double * __restrict s1, const double * __restrict s2,
+                            const double * __restrict s3, const double * __restrict s4, const double * __restrict s5,
+                            const double * __restrict d0, const double * __restrict d1, const double * __restrict d2,
+                            const double * __restrict d3, const double * __restrict d4, const double * __restrict d5,
+                            const float * __restrict duration, double t, int n,
+                            float * __restrict s_out, float * __restrict d_out) {
+    for (int i = 0; i < n; i++) {
+        // a row that has ended is left at its end state
+        double ti = t < duration[i] ? t : duration[i];
+        s_out[i] = ((((s5[i]*ti + s4[i])*ti + s3[i])*ti + s2[i])*ti + s1[i])*ti + s0[i];
+        d_out[i] = ((((d5[i]*ti + d4[i])*ti + d3[i])*ti + d2[i])*ti + d1[i])*ti + d0[i];
+    }
+}
+
+static void prefix_kernel(const float * __restrict previous, float * __restrict current, int n) {
+    for (int i = 0; i < n; i++) {
+        current[i] += previous[i];
+    }
+}
+
+static void interval_kernel(const float * __restrict s, float center, float loop_length, float behind, float inv_cell,
+                            float margin, int cells, int n, int * __restrict c0, int * __restrict c1) {
+    // prefix entries at both ends of the cells s +- margin covers, clamped to [0, cells]
+    for (int i = 0; i < n; i++) {
+        float ds = s[i] - center;
+        if (loop_length > 0) {
+            // shortest way round, as OccupancyGrid::offset
+            float turns = ds/loop_length + 0.5f;
+            float t = (float) (int) turns;
+            ds -= loop_length*(t > turns ? t - 1 : t);
+        }
+        float x0 = (ds + behind - margin)*inv_cell;
+        float x1 = (ds + behind + margin)*inv_cell + 1;
+        x0 = x0 < 0 ? 0 : x0 > cells ? cells : x0;
+        x1 = x1 < 0 ? 0 : x1 > cells ? cells : x1;
+        c0[i] = (int) x0;
+        c1[i] = (int) x1;
+    }
+}
+
+static void lane_kernel(const float * __restrict d, float offset, const RoadModel &model, int n, int * __restrict lane) {
+    // lane under d + offset, -1 left of the road and num_lanes() right of it, as RoadModel::lane_at
+    for (int i = 0; i < n; i++) {
+        lane[i] = d[i] + offset < 0 ? -1 : 0;
+    }
+    for (int k = 1; k <= model.num_lanes(); k++) {
+        float edge = model.edge(k) - offset;
+        for (int i = 0; i < n; i++) {
+            lane[i] += d[i] >= edge;
+        }
+    }
+}
+
+OccupancyGrid::OccupancyGrid() {}
+
+OccupancyGrid::~OccupancyGrid() {}
+
+void OccupancyGrid::reserve(int rows) {
+    this->s_scratch.reserve(rows);
+}
+
+void OccupancyGrid::build(const PredictionStore &predictions, int num_lanes, float s, float horizon, float loop_length) {
+    /*
+    Every hypothesis adds its weight to the cell its vehicle is predicted in at each bin, in the
+    hypothesis' lane. The cells are then summed up along s; with the rows interleaved cell by cell,
+    that pass runs across all rows at once.
+    */
+    this->center = s;
+    this->loop_length = loop_length;
+    this->num_lanes = num_lanes;
+    this->num_cells = (int) ceil((this->behind + this->ahead)/this->cell_size);
+    this->num_bins = (int) ceil(horizon/this->time_step - 1e-3f) + 1;
+    this->num_rows = this->num_bins*num_lanes;
+    int rows = this->num_rows;
+    this->prefix.assign((this->num_cells + 1)*rows, 0);
+    this->s_scratch.resize(predictions.size());
+    const HypothesisPool &pool = predictions.hypotheses();
+    float *p = this->prefix.data();
+    for (int b = 0; b < this->num_bins; b++) {
+        predictions.s_at(b*this->time_step, this->s_scratch.data());
+        for (int h = 0; h < pool.size(); h++) {
+            int lane = pool.lane[h];
+            int c = cell(this->s_scratch[pool.vehicle[h]]);
+            if (lane < 0 || lane >= num_lanes || c < 0 || c >= this->num_cells) continue;
+            p[(c + 1)*rows + b*num_lanes + lane] += pool.weight[h];
+        }
+    }
+    for (int c = 1; c <= this->num_cells; c++) {
+        prefix_kernel(p + (c - 1)*rows, p + c*rows, rows);
+    }
+}
+
+float OccupancyGrid::mass(int lane, float s_min, float s_max, float t) const {
+    if (lane < 0 || lane >= this->num_lanes || this->num_bins == 0) return 0;
+    int b = min(max((int) lround(t/this->time_step), 0), this->num_bins - 1);
+    int c0 = max(cell(s_min), 0);
+    int c1 = min(cell(s_max), this->num_cells - 1);
+    if (c0 > c1) return 0;
+    return sum(b, lane, c0, c1);
+}
+
+void OccupancyGrid::sweep(const TrajectorySet &set, const RoadModel &model, float margin, float half_width, float *risk) const {
+    /*
+    At every bin, the positions of all rows, the cells at both ends of their intervals and the lanes
+    under both sides of the ego are worked out in passes over all rows; the lookups follow row by
+    row, without branches: an interval that misses the grid has c1 + 1 <= c0 and a mass <= 0, and a
+    lane off the road is looked up in the nearest lane and weighted by 0.
+    */
+    int n = set.size();
+    fill(risk, risk + n, 0.0f);
+    if (this->num_bins == 0) return;
+    frame_vector<float> s(n), d(n);
+    frame_vector<int> c0(n), c1(n), left(n), right(n);
+    const vector<double> *sc = set.s_coef, *dc = set.d_coef;
+    int last_lane = this->num_lanes - 1;
+    for (int b = 0; b < this->num_bins; b++) {
+        position_kernel(sc[0].data(), sc[1].data(), sc[2].data(), sc[3].data(), sc[4].data(), sc[5].data(),
+                        dc[0].data(), dc[1].data(), dc[2].data(), dc[3].data(), dc[4].data(), dc[5].data(),
+                        set.T.data(), b*this->time_step, n, s.data(), d.data());
+        interval_kernel(s.data(), this->center, this->loop_length, this->behind, 1/this->cell_size, margin, this->num_cells, n,
+                        c0.data(), c1.data());
+        lane_kernel(d.data(), -half_width, model, n, left.data());
+        lane_kernel(d.data(), half_width, model, n, right.data());
+        int r = b*this->num_lanes;
+        for (int i = 0; i < n; i++) {
+            const float *p0 = &this->prefix[c0[i]*this->num_rows + r];
+            const float *p1 = &this->prefix[c1[i]*this->num_rows + r];
+            int l = min(max(left[i], 0), last_lane);
+            int h = min(max(right[i], 0), last_lane);
+            float on_left = left[i] >= 0 && left[i] <= last_lane;
+            float on_right = right[i] >= 0 && right[i] <= last_lane;
+            float mass = max((p1[l] - p0[l])*on_left, (p1[h] - p0[h])*on_right);
+            risk[i] = max(risk[i], mass);
+        }
+    }
+}
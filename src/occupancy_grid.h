@@ -0,0 +1,95 @@
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+#include <vector>
+#include "road_model.h"
+#include "trajectory_set.h"
+
+using namespace std;
+
+class PredictionStore;
+
+/*
+ * Per-frame s-t occupancy of the predicted traffic. For every lane and every time bin
+ * the hypothesis weight of the vehicles is binned into s cells around the ego and
+ * prefix-summed along s, so the expected number of vehicles in any s interval of a
+ * lane at a time bin is two lookups, whatever the traffic density. Positions are
+ * rounded to the cell they fall in and times to the nearest bin; an interval query
+ * covers every cell it touches. Rebuilt in place every frame without touching the heap.
+ */
+class OccupancyGrid {
+public:
+
+    float cell_size = 1; // m
+    float behind = 16; // m of s covered behind the ego
+    float ahead = 112; // m of s covered ahead of the ego
+    float time_step = 0.2; // s between time bins
+
+    /**
+    * Constructor
+    */
+    OccupancyGrid();
+
+    /**
+    * Destructor
+    */
+    virtual ~OccupancyGrid();
+
+    /*
+     * Bins the hypotheses of every prediction over [0, horizon] seconds and [s - behind, s + ahead) m.
+     * With loop_length > 0 the road is a loop of that length: positions, in the grid and in
+     * queries alike, are taken the short way round from s, as Road::cull does.
+     */
+    void build(const PredictionStore &predictions, int num_lanes, float s, float horizon, float loop_length);
+
+    // makes room for rows vehicles
+    void reserve(int rows);
+
+    int bins() const { return this->num_bins; }
+
+    // hypothesis mass in lane with s inside [s_min, s_max] at the bin nearest t
+    float mass(int lane, float s_min, float s_max, float t) const;
+
+    /*
+     * Highest mass met by every row of set over [0, T], one value per row into risk:
+     * at every time bin, the s interval margin around the row's position in the
+     * lanes under d - half_width and d + half_width.
+     */
+    void sweep(const TrajectorySet &set, const RoadModel &model, float margin, float half_width, float *risk) const;
+
+private:
+
+    // distance from the grid's center to s, the short way round on a loop
+    float offset(float s) const {
+        float ds = s - this->center;
+        if (this->loop_length > 0) {
+            float turns = ds/this->loop_length + 0.5f;
+            float t = (float) (int) turns;
+            ds -= this->loop_length*(t > turns ? t - 1 : t);
+        }
+        return ds;
+    }
+
+    // cell containing s, -1 before the grid and num_cells past it
+    int cell(float s) const {
+        float x = (offset(s) + this->behind)/this->cell_size;
+        return x < 0 ? -1 : x >= this->num_cells ? this->num_cells : (int) x;
+    }
+
+    // mass of lane in [cell c0, cell c1] at bin
+    float sum(int bin, int lane, int c0, int c1) const {
+        int r = bin*this->num_lanes + lane;
+        return this->prefix[(c1 + 1)*this->num_rows + r] - this->prefix[c0*this->num_rows + r];
+    }
+
+    float center = 0; // s the grid was built around
+    float loop_length = 0;
+    int num_lanes = 0;
+    int num_cells = 0;
+    int num_bins = 0;
+    int num_rows = 0; // one per bin and lane
+    // prefix sums of every row along s, cell-major: entry c of a row is the mass of the cells before c
+    vector<float> prefix;
+    vector<float> s_scratch; // s of every prediction at one bin
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "perf_counters.h"
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+PerfCounterGroup::PerfCounterGroup() {
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) this->fds[i] = -1;
+}
+
+PerfCounterGroup::~PerfCounterGroup() {
+    close();
+}
+
+#ifdef __linux__
+
+static int open_counter(uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group_fd < 0 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+bool PerfCounterGroup::open() {
+    close();
+    static const uint64_t configs[NUM_PERF_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        this->fds[i] = open_counter(configs[i], this->fds[0]);
+        if (this->fds[i] < 0) {
+            close();
+            return false;
+        }
+    }
+    ioctl(this->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(this->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+bool PerfCounterGroup::read(PerfSample &sample) const {
+    if (this->fds[0] < 0) return false;
+    // layout for PERF_FORMAT_GROUP: nr, time_enabled, time_running, value[nr]
+    uint64_t data[3 + NUM_PERF_COUNTERS];
+    if (::read(this->fds[0], data, sizeof(data)) != (ssize_t) sizeof(data)) return false;
+    sample.time_enabled = data[1];
+    sample.time_running = data[2];
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        sample.values[i] = data[3 + i];
+    }
+    return true;
+}
+
+#else
+
+bool PerfCounterGroup::open() {
+    return false;
+}
+
+bool PerfCounterGroup::read(PerfSample &sample) const {
+    return false;
+}
+
+#endif
+
+void PerfCounterGroup::delta(const PerfSample &start, const PerfSample &end, uint64_t values[NUM_PERF_COUNTERS]) {
+    uint64_t enabled = end.time_enabled - start.time_enabled;
+    uint64_t running = end.time_running - start.time_running;
+    double scale = 1.0;
+    if (running > 0 && running < enabled) scale = (double) enabled / running;
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        values[i] = (uint64_t) ((end.values[i] - start.values[i]) * scale);
+    }
+}
+
+void PerfCounterGroup::close() {
+    for (int i = NUM_PERF_COUNTERS - 1; i >= 0; i--) {
+        if (this->fds[i] >= 0) ::close(this->fds[i]);
+        this->fds[i] = -1;
+    }
+}
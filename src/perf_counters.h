@@ -0,0 +1,60 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+#include <stdint.h>
+
+/*
+ * Hardware counter group read through Linux perf_event_open. The group counts
+ * for the calling thread only, in user space, and is read in one syscall.
+ * On other platforms, or when the kernel refuses (perf_event_paranoid, containers),
+ * open() returns false and the profiler reports wall time only.
+ */
+
+enum PerfCounter {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    NUM_PERF_COUNTERS
+};
+
+// raw snapshot of the group: counts and the times it was enabled and actually counting, ns
+struct PerfSample {
+    uint64_t time_enabled;
+    uint64_t time_running;
+    uint64_t values[NUM_PERF_COUNTERS];
+};
+
+class PerfCounterGroup {
+public:
+
+    /**
+    * Constructor
+    */
+    PerfCounterGroup();
+
+    /**
+    * Destructor
+    */
+    virtual ~PerfCounterGroup();
+
+    bool open();
+
+    void close();
+
+    bool is_open() const { return this->fds[0] >= 0; }
+
+    // current raw counts; false if the group is not open
+    bool read(PerfSample &sample) const;
+
+    /*
+     * Counts between two samples, scaled once for the share of that interval the
+     * group was multiplexed out. Raw counts only grow, so the deltas never wrap.
+     */
+    static void delta(const PerfSample &start, const PerfSample &end, uint64_t values[NUM_PERF_COUNTERS]);
+
+private:
+
+    int fds[NUM_PERF_COUNTERS];
+};
+
+#endif
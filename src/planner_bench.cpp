@@ -0,0 +1,212 @@
+#include <iostream>
+#include <random>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "prediction_store.h"
+#include "profiler.h"
+#include "road.h"
+#include "thread_pool.h"
+#include "vehicle.h"
+
+using namespace std;
+
+/*
+ * Offline benchmark of the planning stages that do not need the simulator.
+ * Drives Road with deterministic synthetic sensor fusion data and prints the
+ * per-stage profile, after a short warm-up.
+ * Usage: planner_bench [--frames N] [--vehicles N] [--lanes N] [--threads N] [--perf] [--constant-accel] [--no-candidates] [--alloc-budget] [--budget stage=N]
+ *
+ * --alloc-budget needs a build with ALLOC_TRACKING; it fails (exit code 2) when a
+ * single call of any stage allocates more than its budget below. --budget overrides
+ * the budget of one stage, e.g. --budget choose_next_state=0.
+ * --constant-accel predicts with constant acceleration instead of the IDM rollout.
+ * --lanes sets the number of LANE_WIDTH lanes of the synthetic road (default 3).
+ * --threads evaluates the behavior candidates on a pool of N threads (default 1, inline).
+ * --no-candidates decides with the behavior FSM alone, without sampling and checking
+ * the quintic candidates, as PATH_PLANNING_CANDIDATES=0 does for the planner.
+ * The run always fails (exit code 3) if the planner deep-copied the prediction store.
+ */
+
+double REF_VEL=49.0;
+double GOAL_S=6945.554;
+float LANE_WIDTH=4;
+int MAX_ACCEL = 1;
+float TIME_HORIZON=2;
+float MPH_CONVERT=0.447;
+double FRAME_DT=0.02*3; // the simulator usually consumes ~3 path points between messages
+int WARMUP_FRAMES=10;
+
+// heap allocations allowed in one call of each stage with the default 12 vehicles, -1 = unchecked
+long ALLOC_BUDGETS[NUM_STAGES] = {
+    1,     // telemetry (whole frame): the car_data vector handed to populate_traffic2
+    0,     // populate_traffic2
+    0,     // generate_predictions
+    0,     // generate_trajectories
+    0,     // check_feasibility
+    0,     // check_collisions
+    0,     // choose_next_state
+    -1,    // spline_build, not run by the benchmark
+    -1,    // spline_sample, not run by the benchmark
+    -1,    // serialize, not run by the benchmark
+};
+
+struct SyntheticTraffic {
+    vector<vector<double>> cars; // sensor fusion rows: id, x, y, vx, vy, s, d
+
+    SyntheticTraffic(int count, const RoadModel &model, unsigned seed) {
+        mt19937 gen(seed);
+        uniform_real_distribution<double> s_dist(0, 300);
+        uniform_real_distribution<double> v_dist(16, 22);
+        uniform_int_distribution<int> lane_dist(0, model.num_lanes()-1);
+        for (int i = 0; i < count; i++) {
+            double s = s_dist(gen);
+            double d = model.center(lane_dist(gen));
+            cars.push_back({(double) i, s, -d, v_dist(gen), 0, s, d});
+        }
+    }
+
+    void step(double dt) {
+        for (size_t i = 0; i < cars.size(); i++) {
+            cars[i][5] += cars[i][3]*dt;
+            if (cars[i][5] > GOAL_S) cars[i][5] -= GOAL_S;
+            cars[i][1] = cars[i][5];
+        }
+    }
+};
+
+bool set_budget(const char *arg) {
+    const char *eq = strchr(arg, '=');
+    if (eq == NULL) return false;
+    string name(arg, eq - arg);
+    for (int i = 0; i < NUM_STAGES; i++) {
+        if (name == stage_name((Stage) i)) {
+            ALLOC_BUDGETS[i] = atol(eq + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    int frames = 2000;
+    int vehicles = 12;
+    int lanes = 3;
+    int threads = 1;
+    bool perf = false;
+    bool check_budget = false;
+    bool candidates = true;
+    PredictionMode prediction_mode = PREDICT_IDM;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i+1 < argc) frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--vehicles") == 0 && i+1 < argc) vehicles = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--lanes") == 0 && i+1 < argc && atoi(argv[i+1]) >= 2) lanes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--perf") == 0) perf = true;
+        else if (strcmp(argv[i], "--constant-accel") == 0) prediction_mode = PREDICT_CONSTANT_ACCELERATION;
+        else if (strcmp(argv[i], "--no-candidates") == 0) candidates = false;
+        else if (strcmp(argv[i], "--alloc-budget") == 0) check_budget = true;
+        else if (strcmp(argv[i], "--budget") == 0 && i+1 < argc && set_budget(argv[++i])) check_budget = true;
+        else {
+            cerr << "usage: " << argv[0] << " [--frames N] [--vehicles N] [--lanes N] [--threads N] [--perf] [--constant-accel] [--no-candidates] [--alloc-budget] [--budget stage=N]" << endl;
+            return 1;
+        }
+    }
+    if (check_budget && !alloc_tracking_enabled()) {
+        cerr << "--alloc-budget needs a build configured with -DALLOC_TRACKING=ON" << endl;
+        return 1;
+    }
+    if (perf && !profiler.enable_counters()) {
+        cerr << "perf_event_open failed, reporting wall time only" << endl;
+    }
+
+    planner_pool.start(threads);
+    Road road = Road(RoadModel(lanes,LANE_WIDTH,REF_VEL*MPH_CONVERT),TIME_HORIZON);
+    vector<float> ego_config = {(float) (REF_VEL*MPH_CONVERT),(float) lanes,(float) GOAL_S,(float) MAX_ACCEL};
+    road.add_ego2(1,0,road.model.center(1),0,0,(int) State::KL,1,ego_config.data());
+    road.prediction_mode = prediction_mode;
+    road.sample_candidates = candidates;
+    SyntheticTraffic traffic(vehicles, road.model, 42);
+    // the synthetic road runs straight along x with d growing towards -y
+    vector<double> maps_s, maps_x, maps_y, maps_dx, maps_dy;
+    for (double s = 0; s < GOAL_S; s += 30) {
+        maps_s.push_back(s);
+        maps_x.push_back(s);
+        maps_y.push_back(0);
+        maps_dx.push_back(0);
+        maps_dy.push_back(-1);
+    }
+    road.frenet.build(maps_s, maps_x, maps_y, maps_dx, maps_dy, GOAL_S);
+
+    double ego_s = 0;
+    double ego_v = 0;
+    double acc = 0;
+    int car_state = (int) State::KL;
+    int target_lane = 1;
+    uint64_t culled = 0;
+    uint64_t feasible = 0;
+    uint64_t clear = 0;
+    uint64_t colliding = 0;
+    uint64_t chosen = 0;
+    for (int f = 0; f < WARMUP_FRAMES + frames; f++) {
+        if (f == WARMUP_FRAMES) {
+            profiler.reset();
+            PredictionStore::copies = 0;
+            culled = road.vehicles_culled_total;
+        }
+        StageScope frame(STAGE_FRAME);
+        frame_arena.reset();
+        traffic.step(FRAME_DT);
+        Vehicle ego = road.get_ego();
+        vector<double> car_data = {ego_s, 0, ego_s, ego.d, ego_v, acc, (double) car_state, (double) target_lane};
+        road.populate_traffic2(traffic.cars, car_data, FRAME_DT);
+        road.advance();
+        if (f >= WARMUP_FRAMES) {
+            feasible += road.feasibility.count_feasible();
+            colliding += road.collisions.count_collisions();
+            for (int i = 0; i < (int) road.candidate_clear.size(); i++) clear += road.candidate_clear[i];
+            chosen += road.chosen_candidate >= 0;
+        }
+        ego = road.get_ego();
+        ego_v = ego.v_s;
+        ego_s += ego_v*FRAME_DT;
+        if (ego_s > GOAL_S) ego_s -= GOAL_S;
+        acc = ego.a_s;
+        target_lane = ego.target_lane;
+        car_state = (int) ego.state;
+    }
+
+    cout << frames << " frames, " << vehicles << " vehicles, " << lanes << " lanes, " << planner_pool.size() << " threads" << endl;
+    profiler.report(cout);
+    uint64_t decisions = profiler.stats(STAGE_BEHAVIOR).calls;
+    cout << "prediction store copies per decision: "
+         << (decisions > 0 ? (double) PredictionStore::copies / decisions : 0) << endl;
+    if (candidates) {
+        cout << "trajectory candidates per frame: " << road.trajectories.size() << endl;
+        cout << "feasible candidates per frame: " << (double) feasible/frames << endl;
+        cout << "colliding candidates per frame: " << (double) colliding/frames << endl;
+        cout << "clear candidates per frame (feasible, not colliding, under the risk margin): " << (double) clear/frames << endl;
+        cout << "decisions taken from a candidate: " << chosen << " of " << decisions << endl;
+    }
+    cout << "vehicles culled per frame: " << (double) (road.vehicles_culled_total - culled) / frames << endl;
+
+    if (check_budget) {
+        bool over = false;
+        for (int i = 0; i < NUM_STAGES; i++) {
+            const StageStats &s = profiler.stats((Stage) i);
+            if (ALLOC_BUDGETS[i] >= 0 && s.calls > 0 && s.max_allocs > (uint64_t) ALLOC_BUDGETS[i]) {
+                cerr << "allocation budget exceeded: " << stage_name((Stage) i) << " made " << s.max_allocs
+                     << " allocations in one call, budget " << ALLOC_BUDGETS[i] << endl;
+                over = true;
+            }
+        }
+        if (over) return 2;
+        cout << "allocation budgets met" << endl;
+    }
+    // the behavior planner reads the predictions through const references only
+    if (PredictionStore::copies > 0) {
+        cerr << "prediction store deep-copied " << PredictionStore::copies << " times" << endl;
+        return 3;
+    }
+    return 0;
+}
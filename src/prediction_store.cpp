@@ -0,0 +1,139 @@
+#include "prediction_store.h"
+
+uint64_t PredictionStore::copies = 0;
+
+const float IDM_SLOPE_DT = 0.1; // time step of the finite difference giving an IDM vehicle's acceleration
+
+PredictionStore::PredictionStore() {}
+
+PredictionStore::PredictionStore(const PredictionStore &other) {
+    *this = other;
+}
+
+PredictionStore &PredictionStore::operator=(const PredictionStore &other) {
+    this->ids = other.ids;
+    this->lanes = other.lanes;
+    this->s0 = other.s0;
+    this->v = other.v;
+    this->a = other.a;
+    this->d0 = other.d0;
+    this->d_dot0 = other.d_dot0;
+    this->types = other.types;
+    this->index = other.index;
+    this->pool = other.pool;
+    this->idm = other.idm;
+    this->grid = other.grid;
+    this->table = other.table;
+    copies++;
+    return *this;
+}
+
+PredictionStore::~PredictionStore() {}
+
+void PredictionStore::reset() {
+    this->ids.clear();
+    this->lanes.clear();
+    this->s0.clear();
+    this->v.clear();
+    this->a.clear();
+    this->d0.clear();
+    this->d_dot0.clear();
+    this->types.clear();
+    this->idm.clear();
+}
+
+void PredictionStore::reserve(int rows, int num_lanes) {
+    this->ids.reserve(rows);
+    this->lanes.reserve(rows);
+    this->s0.reserve(rows);
+    this->v.reserve(rows);
+    this->a.reserve(rows);
+    this->d0.reserve(rows);
+    this->d_dot0.reserve(rows);
+    this->types.reserve(rows);
+    this->index.reserve(rows, num_lanes);
+    this->pool.reserve(rows);
+    this->idm.reserve(rows);
+    this->grid.reserve(rows);
+    this->table.reserve(rows);
+}
+
+int PredictionStore::add(int id, const MotionModel &model) {
+    this->ids.push_back(id);
+    this->lanes.push_back(model.lane);
+    this->s0.push_back(model.s0);
+    this->v.push_back(model.v);
+    this->a.push_back(motion_acceleration(model));
+    this->d0.push_back(model.d);
+    this->d_dot0.push_back(model.d_dot);
+    this->types.push_back(model.type);
+    return this->ids.size() - 1;
+}
+
+MotionModel PredictionStore::model(int i) const {
+    MotionModel model = {this->s0[i], this->v[i], this->a[i], this->d0[i], this->d_dot0[i],
+                         (int16_t) this->lanes[i], this->types[i]};
+    return model;
+}
+
+Vehicle PredictionStore::state_at(int i, float t) const {
+    /*
+    The lane stays the one the vehicle is in now; d follows the lateral speed.
+    */
+    float d = motion_d_at(this->d0[i], this->d_dot0[i], t);
+    if (this->types[i] == MOTION_IDM) {
+        float v = this->idm.v_at(i, t);
+        float a = (this->idm.v_at(i, t + IDM_SLOPE_DT) - v)/IDM_SLOPE_DT;
+        return Vehicle(this->lanes[i], this->idm.s_at(i, t), d, v, a);
+    }
+    float s = motion_s_at(this->s0[i], this->v[i], this->a[i], t);
+    float v = motion_v_at(this->v[i], this->a[i], t);
+    float a = motion_moving_time(this->v[i], this->a[i], t) < t ? 0 : this->a[i];
+    return Vehicle(this->lanes[i], s, d, v, a);
+}
+
+static void s_at_kernel(const float * __restrict s0, const float * __restrict v, const float * __restrict a,
+                        int n, float t, float * __restrict s_out) {
+    for (int i = 0; i < n; i++) {
+        s_out[i] = motion_s_at(s0[i], v[i], a[i], t);
+    }
+}
+
+void PredictionStore::s_at(float t, float *s_out) const {
+    if (!this->idm.empty()) {
+        this->idm.s_at(t, s_out);
+        return;
+    }
+    s_at_kernel(this->s0.data(), this->v.data(), this->a.data(), size(), t, s_out);
+}
+
+static void v_at_kernel(const float * __restrict v, const float * __restrict a, int n, float t, float * __restrict v_out) {
+    for (int i = 0; i < n; i++) {
+        v_out[i] = motion_v_at(v[i], a[i], t);
+    }
+}
+
+void PredictionStore::v_at(float t, float *v_out) const {
+    if (!this->idm.empty()) {
+        this->idm.v_at(t, v_out);
+        return;
+    }
+    v_at_kernel(this->v.data(), this->a.data(), size(), t, v_out);
+}
+
+static void d_at_kernel(const float * __restrict d0, const float * __restrict d_dot, int n, float t, float * __restrict d_out) {
+    for (int i = 0; i < n; i++) {
+        d_out[i] = motion_d_at(d0[i], d_dot[i], t);
+    }
+}
+
+void PredictionStore::d_at(float t, float *d_out) const {
+    d_at_kernel(this->d0.data(), this->d_dot0.data(), size(), t, d_out);
+}
+
+void PredictionStore::rollout_idm(float horizon, float loop_length, const IdmParams &params) {
+    this->idm.run(this->lanes.data(), this->s0.data(), this->v.data(), size(), horizon, loop_length, params);
+    for (int i = 0; i < size(); i++) {
+        this->types[i] = MOTION_IDM;
+    }
+}
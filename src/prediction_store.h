@@ -0,0 +1,127 @@
+#ifndef PREDICTION_STORE_H
+#define PREDICTION_STORE_H
+#include <stdint.h>
+#include <vector>
+#include "hypothesis_pool.h"
+#include "idm.h"
+#include "motion_model.h"
+#include "vehicle.h"
+#include "neighbour_index.h"
+#include "occupancy_grid.h"
+#include "footprint_table.h"
+
+using namespace std;
+
+enum PredictionMode {
+    PREDICT_CONSTANT_ACCELERATION = 0, // every vehicle keeps its tracked acceleration
+    PREDICT_IDM, // vehicles follow their lane leader, see IdmRollout
+};
+
+/*
+ * Per-frame predictions of the surrounding traffic: one closed-form motion model per
+ * vehicle (motion_model.h), kept as structure of arrays so a query at time t can be
+ * answered for every vehicle in one loop. After rollout_idm() the vehicles are
+ * evaluated from the IDM rollout instead. Road owns the store and rebuilds it in place
+ * every frame; the behavior planner reads it through const references only.
+ */
+class PredictionStore {
+public:
+
+    // deep copies made since start-up; the planner should never make any
+    static uint64_t copies;
+
+    /**
+    * Constructor
+    */
+    PredictionStore();
+
+    PredictionStore(const PredictionStore &other);
+
+    PredictionStore &operator=(const PredictionStore &other);
+
+    /**
+    * Destructor
+    */
+    virtual ~PredictionStore();
+
+    // drops every vehicle, keeping capacity
+    void reset();
+
+    // makes room for rows vehicles in the store, its index, hypotheses and rollout
+    void reserve(int rows, int num_lanes);
+
+    // appends a vehicle and returns its index
+    int add(int id, const MotionModel &model);
+
+    int size() const { return this->ids.size(); }
+
+    int id(int i) const { return this->ids[i]; }
+
+    int lane(int i) const { return this->lanes[i]; }
+
+    // position of vehicle i now
+    float s(int i) const { return this->s0[i]; }
+
+    float d(int i) const { return this->d0[i]; }
+
+    float d_dot(int i) const { return this->d_dot0[i]; }
+
+    MotionModel model(int i) const;
+
+    // vehicle i as predicted t seconds from now
+    Vehicle state_at(int i, float t) const;
+
+    // s of every vehicle t seconds from now, size() values
+    void s_at(float t, float *s_out) const;
+
+    // speed along s and d of every vehicle t seconds from now, size() values
+    void v_at(float t, float *v_out) const;
+    void d_at(float t, float *d_out) const;
+
+    // sorts the current positions into per-lane buckets on a loop of loop_length (0 for an open road); call once all vehicles are added
+    void build_index(int num_lanes, float loop_length) { this->index.build(*this, num_lanes, loop_length); }
+
+    // switches every vehicle to an interacting IDM prediction over horizon seconds; call once all vehicles are added
+    void rollout_idm(float horizon, float loop_length, const IdmParams &params);
+
+    const NeighbourIndex &neighbours() const { return this->index; }
+
+    // weighs keep lane / change left / change right for every vehicle; call once all vehicles are added
+    void build_hypotheses(const RoadModel &model) { this->pool.build(*this, model); }
+
+    const HypothesisPool &hypotheses() const { return this->pool; }
+
+    /*
+     * Bins the hypotheses into the s-t occupancy grid around s over horizon seconds, on a loop of
+     * loop_length (0 for an open road); call after the hypotheses and any rollout.
+     */
+    void build_occupancy(int num_lanes, float s, float horizon, float loop_length) {
+        this->grid.build(*this, num_lanes, s, horizon, loop_length);
+    }
+
+    // hypothesis mass of every lane, interval and time bin as lookups
+    const OccupancyGrid &occupancy() const { return this->grid; }
+
+    // places the footprint of every vehicle on frenet at every step over horizon seconds; call after any rollout
+    void build_footprints(const FrenetMap &frenet, float horizon) { this->table.build(*this, frenet, horizon); }
+
+    const FootprintTable &footprints() const { return this->table; }
+
+private:
+
+    vector<int> ids;
+    vector<int> lanes;
+    vector<float> s0;
+    vector<float> v;
+    vector<float> a; // 0 for constant velocity models
+    vector<float> d0;
+    vector<float> d_dot0;
+    vector<MotionType> types;
+    NeighbourIndex index;
+    HypothesisPool pool;
+    IdmRollout idm;
+    OccupancyGrid grid;
+    FootprintTable table;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "profiler.h"
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <string.h>
+
+Profiler profiler;
+
+static const char *STAGE_NAMES[NUM_STAGES] = {
+    "telemetry", "populate_traffic2", "generate_predictions", "generate_trajectories",
+    "check_feasibility", "check_collisions", "choose_next_state", "spline_build", "spline_sample", "serialize"};
+
+static const char *COUNTER_NAMES[NUM_PERF_COUNTERS] = {
+    "cycles", "instructions", "cache_misses", "branch_misses"};
+
+static int64_t steady_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double per(uint64_t num, uint64_t den, double scale) {
+    return den > 0 ? scale * num / den : 0;
+}
+
+const char *stage_name(Stage stage) {
+    return STAGE_NAMES[stage];
+}
+
+Profiler::Profiler() {
+    reset();
+}
+
+Profiler::~Profiler() {}
+
+bool Profiler::enable_counters() {
+    return this->counters.open();
+}
+
+void Profiler::reset() {
+    memset(this->stage_stats, 0, sizeof(this->stage_stats));
+}
+
+void Profiler::report(ostream &out) const {
+    out << left << setw(22) << "stage" << right << setw(10) << "calls" << setw(12) << "avg_us";
+    if (counters_enabled()) {
+        out << setw(8) << "IPC" << setw(14) << "cache_mpki" << setw(14) << "branch_mpki" << setw(16) << "cache_miss/call";
+    }
+    if (alloc_tracking_enabled()) {
+        out << setw(14) << "allocs/call" << setw(14) << "bytes/call" << setw(12) << "max_allocs";
+    }
+    out << endl;
+    for (int i = 0; i < NUM_STAGES; i++) {
+        const StageStats &s = this->stage_stats[i];
+        if (s.calls == 0) continue;
+        out << left << setw(22) << STAGE_NAMES[i] << right << setw(10) << s.calls
+            << setw(12) << fixed << setprecision(2) << per(s.wall_ns, s.calls, 1e-3);
+        if (counters_enabled()) {
+            out << setw(8) << per(s.counters[PERF_INSTRUCTIONS], s.counters[PERF_CYCLES], 1)
+                << setw(14) << per(s.counters[PERF_CACHE_MISSES], s.counters[PERF_INSTRUCTIONS], 1000)
+                << setw(14) << per(s.counters[PERF_BRANCH_MISSES], s.counters[PERF_INSTRUCTIONS], 1000)
+                << setw(16) << per(s.counters[PERF_CACHE_MISSES], s.calls, 1);
+        }
+        if (alloc_tracking_enabled()) {
+            out << setw(14) << per(s.allocs, s.calls, 1) << setw(14) << per(s.alloc_bytes, s.calls, 1)
+                << setw(12) << s.max_allocs;
+        }
+        out << endl;
+    }
+}
+
+string Profiler::metrics() const {
+    ostringstream out;
+    for (int i = 0; i < NUM_STAGES; i++) {
+        const StageStats &s = this->stage_stats[i];
+        out << "path_planning_stage_calls_total{stage=\"" << STAGE_NAMES[i] << "\"} " << s.calls << "\n";
+        out << "path_planning_stage_seconds_total{stage=\"" << STAGE_NAMES[i] << "\"} " << s.wall_ns * 1e-9 << "\n";
+        if (alloc_tracking_enabled()) {
+            out << "path_planning_stage_allocations_total{stage=\"" << STAGE_NAMES[i] << "\"} " << s.allocs << "\n";
+            out << "path_planning_stage_allocated_bytes_total{stage=\"" << STAGE_NAMES[i] << "\"} " << s.alloc_bytes << "\n";
+            out << "path_planning_stage_max_allocations{stage=\"" << STAGE_NAMES[i] << "\"} " << s.max_allocs << "\n";
+        }
+        if (!counters_enabled()) continue;
+        for (int c = 0; c < NUM_PERF_COUNTERS; c++) {
+            out << "path_planning_stage_" << COUNTER_NAMES[c] << "_total{stage=\"" << STAGE_NAMES[i] << "\"} "
+                << s.counters[c] << "\n";
+        }
+        out << "path_planning_stage_ipc{stage=\"" << STAGE_NAMES[i] << "\"} "
+            << per(s.counters[PERF_INSTRUCTIONS], s.counters[PERF_CYCLES], 1) << "\n";
+        out << "path_planning_stage_cache_misses_per_kinstr{stage=\"" << STAGE_NAMES[i] << "\"} "
+            << per(s.counters[PERF_CACHE_MISSES], s.counters[PERF_INSTRUCTIONS], 1000) << "\n";
+    }
+    return out.str();
+}
+
+StageScope::StageScope(Stage stage) : trace(STAGE_NAMES[stage]) {
+    this->stage = stage;
+    if (!profiler.counters.read(this->start_counters)) {
+        memset(&this->start_counters, 0, sizeof(this->start_counters));
+    }
+    this->start_allocs = alloc_counters();
+    this->start_ns = steady_ns();
+}
+
+StageScope::~StageScope() {
+    int64_t end_ns = steady_ns();
+    AllocCounters end_allocs = alloc_counters();
+    StageStats &s = profiler.stage_stats[this->stage];
+    s.calls++;
+    s.wall_ns += end_ns - this->start_ns;
+    uint64_t allocs = end_allocs.allocs - this->start_allocs.allocs;
+    s.allocs += allocs;
+    s.alloc_bytes += end_allocs.bytes - this->start_allocs.bytes;
+    s.max_allocs = max(s.max_allocs, allocs);
+    PerfSample end_counters;
+    if (profiler.counters.read(end_counters)) {
+        uint64_t counts[NUM_PERF_COUNTERS];
+        PerfCounterGroup::delta(this->start_counters, end_counters, counts);
+        for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+            s.counters[i] += counts[i];
+        }
+    }
+}
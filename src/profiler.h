@@ -0,0 +1,99 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include "alloc_tracker.h"
+#include "perf_counters.h"
+#include "trace.h"
+
+using namespace std;
+
+/*
+ * Per-stage accounting of the planning cycle. Every stage is wrapped in a
+ * StageScope, which always accumulates wall time, emits a trace event when
+ * tracing is on, adds hardware counter deltas when counters are enabled, and
+ * heap allocation counts when built with ALLOC_TRACKING.
+ * Stages are meant to run on the planning thread; nesting is allowed.
+ */
+
+enum Stage {
+    STAGE_FRAME = 0, // one whole telemetry message
+    STAGE_TRAFFIC,
+    STAGE_PREDICTION,
+    STAGE_TRAJECTORY, // sampled quintic candidates
+    STAGE_FEASIBILITY, // limit checks of the candidates
+    STAGE_COLLISION, // collision checks of the candidates
+    STAGE_BEHAVIOR,
+    STAGE_SPLINE_BUILD,
+    STAGE_SPLINE_SAMPLE,
+    STAGE_SERIALIZE,
+    NUM_STAGES
+};
+
+const char *stage_name(Stage stage);
+
+struct StageStats {
+    uint64_t calls;
+    uint64_t wall_ns;
+    uint64_t counters[NUM_PERF_COUNTERS];
+    uint64_t allocs;
+    uint64_t alloc_bytes;
+    uint64_t max_allocs; // worst single call
+};
+
+class Profiler {
+public:
+
+    /**
+    * Constructor
+    */
+    Profiler();
+
+    /**
+    * Destructor
+    */
+    virtual ~Profiler();
+
+    // opens the perf_event counter group for the calling thread; false if unavailable
+    bool enable_counters();
+
+    bool counters_enabled() const { return this->counters.is_open(); }
+
+    void reset();
+
+    const StageStats &stats(Stage stage) const { return this->stage_stats[stage]; }
+
+    // human readable per-stage table (benchmark output)
+    void report(ostream &out) const;
+
+    // Prometheus text exposition (served on /metrics)
+    string metrics() const;
+
+private:
+
+    friend class StageScope;
+
+    PerfCounterGroup counters;
+    StageStats stage_stats[NUM_STAGES];
+};
+
+extern Profiler profiler;
+
+class StageScope {
+public:
+
+    StageScope(Stage stage);
+
+    ~StageScope();
+
+private:
+
+    Stage stage;
+    int64_t start_ns;
+    PerfSample start_counters;
+    AllocCounters start_allocs;
+    TraceScope trace;
+};
+
+#endif
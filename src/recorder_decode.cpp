@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+#include <vector>
+#include "flight_recorder.h"
+
+using namespace std;
+
+/*
+ * Offline decoder for flight_recorder.bin (or its .dump copy).
+ * Usage: recorder_decode <file> [last_n_frames]
+ * Prints the recorded frames oldest first.
+ */
+
+bool by_seq(const RecFrame *a, const RecFrame *b) {
+    return a->seq < b->seq;
+}
+
+void print_vehicle(const RecVehicle &v) {
+    cout << "id=" << v.id << " lane=" << v.lane << " s=" << v.s << " d=" << v.d
+         << " v=" << v.v_s << " a=" << v.a_s;
+}
+
+void print_frame(const RecFrame &f) {
+    cout << "frame " << f.seq << " t_us=" << f.t_us << endl;
+    cout << "  ego ";
+    print_vehicle(f.ego);
+    cout << " state=" << f.ego_state << " target_lane=" << f.target_lane << " culled=" << f.num_culled << endl;
+    for (int i = 0; i < f.num_candidates && i < REC_MAX_CANDIDATES; i++) {
+        cout << "  candidate " << f.candidates[i].state << " cost=" << f.candidates[i].cost
+             << (i == f.chosen ? " <- chosen" : "") << endl;
+    }
+    for (int i = 0; i < f.num_vehicles && i < REC_MAX_VEHICLES; i++) {
+        cout << "  car ";
+        print_vehicle(f.vehicles[i]);
+        cout << endl;
+    }
+    cout << "  path";
+    for (int i = 0; i < f.num_points && i < REC_MAX_POINTS; i++) {
+        cout << " (" << f.next_x[i] << "," << f.next_y[i] << ")";
+    }
+    cout << endl;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " <recorder file> [last_n_frames]" << endl;
+        return 1;
+    }
+    ifstream in(argv[1], ios::binary);
+    if (!in) {
+        cerr << "cannot open " << argv[1] << endl;
+        return 1;
+    }
+    RecHeader header;
+    in.read((char *) &header, sizeof(header));
+    if (!in || header.magic != REC_MAGIC || header.version != REC_VERSION
+        || header.frame_size != sizeof(RecFrame)) {
+        cerr << argv[1] << " is not a flight recorder file of this build" << endl;
+        return 1;
+    }
+
+    vector<RecFrame> frames(header.capacity);
+    in.read((char *) frames.data(), sizeof(RecFrame) * header.capacity);
+    size_t read_frames = in.gcount() / sizeof(RecFrame);
+
+    vector<const RecFrame *> valid;
+    for (size_t i = 0; i < read_frames; i++) {
+        if (frames[i].seq != 0) valid.push_back(&frames[i]);
+    }
+    sort(valid.begin(), valid.end(), by_seq);
+
+    size_t first = 0;
+    if (argc > 2) {
+        size_t last_n = atoi(argv[2]);
+        if (last_n < valid.size()) first = valid.size() - last_n;
+    }
+    for (size_t i = first; i < valid.size(); i++) {
+        print_frame(*valid[i]);
+    }
+    cerr << valid.size() << " frames recorded, next sequence " << header.next_seq << endl;
+    return 0;
+}
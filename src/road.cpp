@@ -1,134 +1,309 @@
 #include <iostream>
 #include "road.h"
 #include "vehicle.h"
+#include "profiler.h"
 #include <math.h>
 #include <map>
 #include <string>
 #include <iterator>
 #include <cmath>
+#include <algorithm>
 #include <vector>
-#include "Eigen-3.3/Eigen/Dense"
+#include "jmt_solver.h"
+#include "cost.h"
 
 using namespace std;
-using Eigen::MatrixXd;
-using Eigen::VectorXd;
 
 
 /*
  * Initializes Road
  */
-Road::Road(float speed_limit, vector<float> lane_speeds,int lane_width, float time_horizon,float mph_convert) {
+Road::Road(const RoadModel &model, float time_horizon) {
 
-    this->num_lanes = lane_speeds.size();
-    this->lane_speeds = lane_speeds;
-    this->speed_limit = speed_limit;
-    this->lane_width=lane_width;
+    this->model = model;
     this->time_horizon=time_horizon;
-    this->mph_convert=mph_convert;
 }
 
 Road::~Road() {}
 
 Vehicle Road::get_ego() {
 
-	return this->vehicles.find(this->ego_key)->second;
+	return this->ego;
 }
 
-void Road::populate_traffic2(vector<vector<double>> sf_data,vector<double> car_data) {
+void Road::populate_traffic2(const vector<vector<double>> &sf_data,const vector<double> &car_data,double dt) {
+	/*
+	Updates the tracks with this frame's sensor fusion rows, dt seconds after the previous frame,
+	and lists the filtered estimates of the vehicles seen in this frame in the traffic table.
+	The Cartesian velocities are first split into s and d speeds in one batch over all rows.
+	*/
+	StageScope stage(STAGE_TRAFFIC);
 	Vehicle mycar=this->get_ego();
 	this->vehicles_added=0;
-	this->vehicles.clear();
-	for (int i = 0; i < sf_data.size(); i++){
-		vector<double> car=sf_data[i];
-      	double x = car[1];
-      	double y = car[2];
-      	double vx = car[3];
-      	double vy = car[4];
-      	double s = car[5];
-      	double d = car[6];
-      	int lane=d/lane_width;
-      	double speed=sqrt(vx*vx+vy*vy);
-		Vehicle vehicle = Vehicle(lane,s,d,speed,0,"CS");
+	this->traffic.clear();
+	int rows = sf_data.size();
+	this->sf_s.resize(rows);
+	this->sf_vx.resize(rows);
+	this->sf_vy.resize(rows);
+	this->sf_s_dot.resize(rows);
+	this->sf_d_dot.resize(rows);
+	for (int i = 0; i < rows; i++){
+		const vector<double> &car=sf_data[i];
+		this->sf_vx[i] = car[3];
+		this->sf_vy[i] = car[4];
+		this->sf_s[i] = car[5];
+	}
+	this->frenet.project_velocities(this->sf_s.data(),this->sf_vx.data(),this->sf_vy.data(),rows,this->sf_s_dot.data(),this->sf_d_dot.data());
+	this->tracks.set_loop_length(mycar.goal_s);
+	this->tracks.begin_frame(dt);
+	for (int i = 0; i < rows; i++){
+		int id = sf_data[i][0];
+		double d = sf_data[i][6];
+		this->tracks.update(id,this->sf_s[i],d,this->sf_s_dot[i],this->sf_d_dot[i]);
+	}
+	this->tracks.end_frame();
+	// every tracked vehicle may come into range, so later stages never grow their buffers mid-run
+	this->traffic.reserve(this->tracks.slots());
+	this->cull_keep.reserve(this->tracks.slots());
+	this->predictions.reserve(this->tracks.slots(),this->model.num_lanes());
+	this->collisions.reserve(this->tracks.slots());
+	for (int slot = 0; slot < this->tracks.slots(); slot++){
+		if (this->tracks.id[slot] < 0 || this->tracks.missed[slot] > 0) continue;
+		float s = this->tracks.s[slot];
+		float d = this->tracks.d[slot];
+		int lane=this->model.lane_at(d);
 		this->vehicles_added += 1;
-		this->vehicles.insert(std::pair<int,Vehicle>(vehicles_added,vehicle));
+		this->traffic.add(this->tracks.id[slot],lane,s,d,this->tracks.v_s[slot],this->tracks.a_s[slot],this->tracks.d_dot[slot]);
 	}
-	vector<float> ego_conf={this->speed_limit*this->mph_convert,this->num_lanes,mycar.goal_s,mycar.max_acceleration};
-	int lane_num=car_data[3]/this->lane_width;
+	float ego_conf[]={this->model.max_speed_limit(),(float) this->model.num_lanes(),mycar.goal_s,mycar.max_acceleration};
+	int lane_num=min(max(this->model.lane_at(car_data[3]),0),this->model.num_lanes()-1);
 	this->add_ego2(lane_num,car_data[2],car_data[3],car_data[4],car_data[5],car_data[6],car_data[7],ego_conf);
+	this->cull();
+}
+
+static void cull_kernel(const float * __restrict s, const float * __restrict d, int n, float ego_s, float ego_d,
+                        float loop_length, float ahead, float behind, float lateral, uint8_t * __restrict keep) {
+	for (int i = 0; i < n; i++) {
+		float ds = s[i] - ego_s;
+		if (loop_length > 0) {
+			// shortest way round: into [-loop_length/2, loop_length/2)
+			float turns = ds/loop_length + 0.5f;
+			float t = (float) (int) turns;
+			ds -= loop_length*(t > turns ? t - 1 : t);
+		}
+		float dd = d[i] - ego_d;
+		keep[i] = ds <= ahead && ds >= -behind && dd <= lateral && dd >= -lateral;
+	}
+}
+
+void Road::cull() {
+	/*
+	Keeps the vehicles at most cull_ahead in front of and cull_behind behind the ego along s, the
+	track being a loop of the ego's goal_s, and at most cull_lateral to either side. The tracks keep
+	every vehicle, so one coming back into range resumes with its history.
+	*/
+	int rows = this->traffic.size();
+	this->cull_keep.resize(rows);
+	cull_kernel(this->traffic.s.data(),this->traffic.d.data(),rows,this->ego.s,this->ego.d,this->ego.goal_s,
+	            this->cull_ahead,this->cull_behind,this->cull_lateral,this->cull_keep.data());
+	this->traffic.retain(this->cull_keep.data());
+	this->vehicles_culled = rows - this->traffic.size();
+	this->vehicles_culled_total += this->vehicles_culled;
+}
+
+static void clear_kernel(const uint8_t * __restrict feasible, const uint8_t * __restrict collides, const float * __restrict risk,
+                         int n, float max_risk, uint8_t * __restrict clear) {
+	for(int i = 0; i < n; i++){
+		clear[i] = feasible[i] && !collides[i] && risk[i] < max_risk;
+	}
 }
 
 void Road::advance() {
 
-	map<int ,vector<Vehicle> > predictions;
-	map<int, Vehicle>::iterator it = this->vehicles.begin();
-	float current_speed=0;
-
-    while(it != this->vehicles.end()){
-        int v_id = it->first;
-        if(v_id != ego_key){
-            vector<Vehicle> preds = it->second.generate_predictions(time_horizon);
-            predictions[v_id] = preds;
-        }
-        it++;
-    }
-	it = this->vehicles.begin();
-	while(it != this->vehicles.end()){
-    	int v_id = it->first;
-        if(v_id == ego_key){
-        	Vehicle mycar=this->get_ego();
-        	if(mycar.lane==mycar.target_lane){
-            	vector<Vehicle> trajectory = it->second.choose_next_state(predictions,time_horizon);
-            	it->second.realize_next_state(trajectory);
-        	}else{
-        		vector<float> kinematics=mycar.get_kinematics(predictions,mycar.target_lane,time_horizon);
-        		it->second.s=kinematics[0];
-        		it->second.v_s=kinematics[1];
-        		it->second.a_s=kinematics[2];
-        		it->second.lane=mycar.target_lane;
-        		it->second.d=4*mycar.target_lane+2;
-        		/*double delta_d=1;
-        		if(mycar.target_lane<mycar.lane) delta_d=-2;
-        		it->second.d+=delta_d;*/
-        	}
-        }else{
-            it->second.s_increment(time_horizon);
-        }
-        it++;
-    }
+	// the log outlives the frame arena, so it keeps its own storage, sized once for every state
+	this->last_decision.states.clear();
+	this->last_decision.costs.clear();
+	this->last_decision.states.reserve(NUM_STATES);
+	this->last_decision.costs.reserve(NUM_STATES);
+	this->last_decision.best = -1;
+	this->chosen_candidate = -1;
+
+	{
+	StageScope stage(STAGE_PREDICTION);
+	this->predictions.reset();
+	for(int i = 0; i < this->traffic.size(); i++){
+		this->predictions.add(this->traffic.id[i],this->traffic.motion_model(i));
+	}
+	this->predictions.build_index(this->model.num_lanes(),this->ego.goal_s);
+	this->predictions.build_hypotheses(this->model);
+	// covers the behavior horizon and the longest sampled candidate, so no consumer reads past the rollout
+	float horizon=max(time_horizon,this->generator.params.max_duration);
+	if(this->prediction_mode==PREDICT_IDM){
+		this->predictions.rollout_idm(horizon,this->ego.goal_s,this->idm);
+	}
+	this->predictions.build_occupancy(this->model.num_lanes(),this->ego.s,horizon,this->ego.goal_s);
+	// only the candidate collision check reads the footprints
+	if(this->sample_candidates){
+		this->predictions.build_footprints(this->frenet,horizon);
+	}
+	}
+	const PredictionStore &predictions = this->predictions;
+
+	if(this->sample_candidates){
+		{
+		StageScope stage(STAGE_TRAJECTORY);
+		Vehicle mycar=this->get_ego();
+		double s_start[]={mycar.s,mycar.v_s,mycar.a_s};
+		double d_start[]={mycar.d,0,0};
+		this->generator.generate(s_start,d_start,this->model,this->trajectories);
+		}
+		{
+		StageScope stage(STAGE_FEASIBILITY);
+		this->feasibility.check(this->trajectories,this->limits);
+		}
+		{
+		StageScope stage(STAGE_COLLISION);
+		this->collision_risk.resize(this->trajectories.size());
+		this->candidate_clear.resize(this->trajectories.size());
+		predictions.occupancy().sweep(this->trajectories,this->model,this->collision_margin,this->ego_half_width,this->collision_risk.data());
+		this->collisions.check(this->trajectories,this->frenet,predictions.footprints());
+		clear_kernel(this->feasibility.feasible.data(),this->collisions.collides.data(),this->collision_risk.data(),
+		             this->trajectories.size(),this->max_collision_risk,this->candidate_clear.data());
+		}
+	}
+
+	{
+	StageScope stage(STAGE_BEHAVIOR);
+	Vehicle mycar=this->get_ego();
+	if(mycar.lane==mycar.target_lane){
+		frame_vector<Vehicle> trajectory;
+		if(this->sample_candidates) trajectory = this->choose_candidate();
+		if(trajectory.size()<2) trajectory = this->ego.choose_next_state(predictions,time_horizon,&this->last_decision);
+		if(trajectory.size()>1) this->ego.realize_next_state(trajectory);
+	}else{
+		frame_vector<float> kinematics=mycar.get_kinematics(predictions,mycar.target_lane,time_horizon);
+		this->ego.s=kinematics[0];
+		this->ego.v_s=kinematics[1];
+		this->ego.a_s=kinematics[2];
+		this->ego.lane=mycar.target_lane;
+		this->ego.d=this->model.center(mycar.target_lane);
+		/*double delta_d=1;
+		if(mycar.target_lane<mycar.lane) delta_d=-2;
+		this->ego.d+=delta_d;*/
+	}
+	}
+
+	for(int i = 0; i < this->traffic.size(); i++){
+		float t = this->time_horizon;
+		this->traffic.s[i] += this->traffic.v_s[i]*t + this->traffic.a_s[i]*t*t/2.0;
+	}
+}
+
+// the maneuver moving delta lanes in one decision, CS if there is none
+static State lane_change_state(int delta) {
+	switch(delta){
+	case -2: return State::LCL2;
+	case -1: return State::LCL;
+	case 0: return State::KL;
+	case 1: return State::LCR;
+	case 2: return State::LCR2;
+	}
+	return State::CS;
+}
+
+// whether the lanes row i of set crosses from from_lane stay below max_risk around the ego at every time bin up to
+// horizon, the ego being taken into each of them from the start like a lane change of the FSM
+static bool crossing_clear(const TrajectorySet &set, int i, int from_lane, const OccupancyGrid &occupancy, float horizon,
+                           float margin, float max_risk) {
+	int direction = set.lane[i] > from_lane ? 1 : -1;
+	for(int b = 0; b*occupancy.time_step <= horizon + 1e-3f; b++){
+		float t = b*occupancy.time_step;
+		float s = set.s_at(i,min(t,set.T[i])) + set.target_v[i]*max(t-set.T[i],0.0f);
+		for(int lane = from_lane + direction; lane != set.lane[i] + direction; lane += direction){
+			if(occupancy.mass(lane,s-margin,s+margin,t)>=max_risk) return false;
+		}
+	}
+	return true;
 }
 
-void Road::add_ego2(int lane_num, float s,float d,float v,float a,int state_of_car,int target_lane, vector<float> config_data) {
-	string car_state="KL";
-	if(state_of_car==1) car_state="LCR";
-	if(state_of_car==-1) car_state="LCL";
+frame_vector<Vehicle> Road::choose_candidate() {
+	/*
+	Every clear candidate is taken to its state at the behavior horizon, one shorter than that cruising
+	on at its end speed, and costed like the FSM's trajectories. A lane change must also find the lanes
+	it crosses clear from the start, as the FSM does, since the emitted path does not follow the lateral quintic.
+	OUTPUT: the ego and the end state of the cheapest one, empty if none passed. The decision log
+	receives the chosen state and its cost.
+	*/
+	Vehicle mycar=this->get_ego();
+	const TrajectorySet &set=this->trajectories;
+	frame_vector<Vehicle> ends;
+	frame_vector<int> rows;
+	ends.reserve(set.size());
+	rows.reserve(set.size());
+	for(int i = 0; i < set.size(); i++){
+		if(!this->candidate_clear[i]) continue;
+		State state=lane_change_state(set.lane[i]-mycar.lane);
+		if(state==State::CS) continue;
+		if(state!=State::KL && !crossing_clear(set,i,mycar.lane,this->predictions.occupancy(),this->time_horizon,
+		                                      this->collision_margin,this->max_collision_risk)) continue;
+		float t=min(this->time_horizon,set.T[i]);
+		Vehicle end=mycar;
+		end.state=state;
+		end.lane=set.lane[i];
+		end.target_lane=set.lane[i];
+		end.d=set.target_d[i];
+		end.v_s=set.s_dot_at(i,t);
+		end.a_s=set.s_ddot_at(i,t);
+		end.s=set.s_at(i,t)+end.v_s*(this->time_horizon-t);
+		ends.push_back(end);
+		rows.push_back(i);
+	}
+	if(ends.empty()){
+		return frame_vector<Vehicle>();
+	}
+
+	CostContext context = {mycar.goal_s, this->predictions, this->time_horizon};
+	frame_vector<float> costs(ends.size());
+	BehaviorCost::batch(ends.data(),ends.size(),context,costs.data());
+	int best=distance(costs.begin(),min_element(costs.begin(),costs.end()));
+	this->chosen_candidate=rows[best];
+	this->last_decision.states.push_back(ends[best].state);
+	this->last_decision.costs.push_back(costs[best]);
+	this->last_decision.best=0;
+
+	frame_vector<Vehicle> trajectory;
+	trajectory.push_back(mycar);
+	trajectory.push_back(ends[best]);
+	return trajectory;
+}
+
+void Road::add_ego2(int lane_num, float s,float d,float v,float a,int state_of_car,int target_lane, const float *config_data) {
+	State car_state=State::KL;
+	if(state_of_car>=0 && state_of_car<NUM_STATES) car_state=(State) state_of_car;
 
     Vehicle ego = Vehicle(lane_num, s,d, v, a,car_state,target_lane);
     ego.configure(config_data);
-    this->vehicles.insert(std::pair<int,Vehicle>(ego_key,ego));
+    ego.road_model = &this->model;
+    this->ego = ego;
 }
 
-vector<double> Road::JMT(vector< double> start, vector <double> end, double T)
+vector<double> Road::JMT(const vector< double> &start, const vector <double> &end, double T)
 {
-
-    MatrixXd A = MatrixXd(3, 3);
-	A << T*T*T, T*T*T*T, T*T*T*T*T,
-			    3*T*T, 4*T*T*T,5*T*T*T*T,
-			    6*T, 12*T*T, 20*T*T*T;
-
-	MatrixXd B = MatrixXd(3,1);
-	B << end[0]-(start[0]+start[1]*T+.5*start[2]*T*T),
+	/*
+	Single-trajectory form of JmtSolver, for callers outside the batched sampler.
+	*/
+	double Ai[9];
+	jmt_inverse(T, Ai);
+	double B[] = {end[0]-(start[0]+start[1]*T+.5*start[2]*T*T),
 			    end[1]-(start[1]+start[2]*T),
-			    end[2]-start[2];
+			    end[2]-start[2]};
 
-	MatrixXd Ai = A.inverse();
-	MatrixXd C = Ai*B;
-	vector <double> result = {start[0], start[1], .5*start[2]};
-	for(int i = 0; i < C.size(); i++)
+	vector <double> result = {start[0], start[1], .5*start[2], 0, 0, 0};
+	for(int i = 0; i < 3; i++)
 	{
-	    result.push_back(C.data()[i]);
+	    result[3+i] = Ai[3*i]*B[0]+Ai[3*i+1]*B[1]+Ai[3*i+2]*B[2];
 	}
 
     return result;
 
 }
-
@@ -1,3 +1,5 @@
+#ifndef ROAD_H
+#define ROAD_H
 #include <iostream>
 #include <random>
 #include <sstream>
@@ -9,6 +11,14 @@
 #include <string>
 #include <iterator>
 #include "vehicle.h"
+#include "traffic_table.h"
+#include "prediction_store.h"
+#include "track_store.h"
+#include "frenet_map.h"
+#include "road_model.h"
+#include "trajectory_generator.h"
+#include "feasibility.h"
+#include "collision_checker.h"
 
 using namespace std;
 
@@ -16,19 +26,46 @@ class Road {
 public:
 
   	int ego_key = -1;
-  	int num_lanes;
-    vector<float> lane_speeds;
-    float speed_limit;
-    int lane_width;
-    map<int, Vehicle> vehicles;
+    RoadModel model; // lane count, widths and speed limits
+    FrenetMap frenet; // Frenet frames along the track, empty until built from the waypoints
+    TrackStore tracks; // persistent tracks keyed by sensor fusion id
+    TrafficTable traffic; // every vehicle but the ego, as seen this frame
+    Vehicle ego; // ego slot, id ego_key
+    PredictionStore predictions; // rebuilt by advance() every frame
+    PredictionMode prediction_mode = PREDICT_IDM;
+    IdmParams idm; // used with PREDICT_IDM
     int vehicles_added = 0;
+    // traffic kept by cull(): s window around the ego (wrapping at the ego's goal_s) and lateral window, m
+    float cull_ahead = 200;
+    float cull_behind = 60;
+    float cull_lateral = 12;
+    int vehicles_culled = 0; // dropped by the last cull()
+    uint64_t vehicles_culled_total = 0;
+    // samples and checks the candidates below every advance() and decides on the cheapest one that passes;
+    // off, or when none passes, the FSM decides
+    bool sample_candidates = true;
+    TrajectoryGenerator generator;
+    TrajectorySet trajectories; // candidates sampled from the ego's state before the last advance()
+    FeasibilityLimits limits;
+    FeasibilityChecker feasibility; // one row per candidate in trajectories
+    // occupancy swept by every candidate: s kept clear ahead and behind and half the ego's width, m
+    float collision_margin = 5;
+    float ego_half_width = 1;
+    vector<float> collision_risk; // one row per candidate in trajectories, highest expected number of vehicles met
+    CollisionChecker collisions; // one row per candidate in trajectories, against the traffic footprints
+    float max_collision_risk = 0.5; // expected vehicles met at which a candidate is rejected
+    vector<uint8_t> candidate_clear; // one row per candidate: feasible, not colliding and under max_collision_risk
+    int chosen_candidate = -1; // row of trajectories the last decision took, -1 if the FSM decided or none was made
+    Vehicle::decision last_decision; // ego's last behavior decision, kept for the flight recorder
     float time_horizon;
-    float mph_convert;
+    // sensor fusion columns of the current frame, input and output of the velocity projection
+    vector<float> sf_s, sf_vx, sf_vy, sf_s_dot, sf_d_dot;
+    vector<uint8_t> cull_keep;
 
     /**
   	* Constructor
   	*/
-  	Road(float speed_limit, vector<float> lane_speeds,int lane_width, float time_horizon,float mph_convert);
+  	Road(const RoadModel &model, float time_horizon);
 
   	/**
   	* Destructor
@@ -37,14 +74,22 @@ public:
 
   	Vehicle get_ego();
 
-  	void populate_traffic2(vector<vector<double>> sf_data,vector<double> car_data);
+  	void populate_traffic2(const vector<vector<double>> &sf_data,const vector<double> &car_data,double dt);
 
   	void advance();
 
-  	void add_ego2(int lane_num, float s,float d,float v,float a,int state_of_car,int target_lane, vector<float> config_data);
+  	// the ego and the end state of the cheapest clear candidate, empty if none is clear
+  	frame_vector<Vehicle> choose_candidate();
 
+  	// state_of_car is the (int) State the ego was left in by the last advance()
+  	void add_ego2(int lane_num, float s,float d,float v,float a,int state_of_car,int target_lane, const float *config_data);
+
+  	// drops the traffic outside the cull windows around the ego
   	void cull();
 
-  	vector<double> JMT(vector< double> start, vector <double> end, double T);
+  	// quintic coefficients, lowest order first, from start to end (position, speed, acceleration) in T seconds
+  	static vector<double> JMT(const vector< double> &start, const vector <double> &end, double T);
 
 };
+
+#endif
@@ -0,0 +1,64 @@
+#include "road_model.h"
+#include <fstream>
+#include <sstream>
+
+RoadModel::RoadModel() {}
+
+RoadModel::RoadModel(int num_lanes, float lane_width, float speed_limit) {
+    set_lanes(vector<float>(num_lanes, lane_width), vector<float>(num_lanes, speed_limit));
+}
+
+RoadModel::~RoadModel() {}
+
+void RoadModel::set_lanes(const vector<float> &widths, const vector<float> &speed_limits) {
+    this->widths = widths;
+    this->speed_limits = speed_limits;
+    this->speed_limits.resize(widths.size(), speed_limits.empty() ? 0 : speed_limits.back());
+    this->centers.resize(widths.size());
+    this->edges.resize(widths.size() + 1);
+    this->edges[0] = 0;
+    for (int i = 0; i < num_lanes(); i++) {
+        this->centers[i] = this->edges[i] + widths[i]/2;
+        this->edges[i + 1] = this->edges[i] + widths[i];
+    }
+}
+
+bool RoadModel::load(const string &file, float speed_scale) {
+    ifstream in(file.c_str(), ifstream::in);
+    if (!in) return false;
+    vector<float> widths;
+    vector<float> speed_limits;
+    string line;
+    while (getline(in, line)) {
+        istringstream iss(line);
+        float width;
+        float speed;
+        if (line.empty() || line[0] == '#' || !(iss >> width >> speed) || width <= 0) continue;
+        widths.push_back(width);
+        speed_limits.push_back(speed*speed_scale);
+    }
+    if (widths.empty()) return false;
+    set_lanes(widths, speed_limits);
+    return true;
+}
+
+float RoadModel::max_speed_limit() const {
+    float limit = 0;
+    for (int i = 0; i < num_lanes(); i++) {
+        if (this->speed_limits[i] > limit) limit = this->speed_limits[i];
+    }
+    return limit;
+}
+
+int RoadModel::lane_at(float d) const {
+    /*
+    Linear scan over the borders: highways have a handful of lanes, and the scan
+    has no data-dependent jumps into the table.
+    */
+    if (d < 0) return -1;
+    int lane = 0;
+    for (int i = 1; i <= num_lanes(); i++) {
+        lane += d >= this->edges[i];
+    }
+    return lane;
+}
@@ -0,0 +1,64 @@
+#ifndef ROAD_MODEL_H
+#define ROAD_MODEL_H
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Lane layout of the road: how many lanes there are, how wide each one is and
+ * its speed limit. Lane 0 is next to the center line (d = 0) and d grows
+ * outwards, so lane i covers [edge(i), edge(i+1)). Widths may differ per lane;
+ * the edges and centers are precomputed whenever the layout changes.
+ */
+class RoadModel {
+public:
+
+    /**
+    * Constructor
+    */
+    RoadModel();
+    RoadModel(int num_lanes, float lane_width, float speed_limit);
+
+    /**
+    * Destructor
+    */
+    virtual ~RoadModel();
+
+    // replaces the layout; widths in m and speed limits in m/s, one entry per lane
+    void set_lanes(const vector<float> &widths, const vector<float> &speed_limits);
+
+    /*
+     * Reads the layout from a text file with one line per lane, from the center line
+     * outwards: the lane width in m and its speed limit, which is multiplied by
+     * speed_scale (e.g. MPH to m/s). Lines starting with # are skipped. Returns false
+     * and keeps the current layout if the file cannot be read or lists no lanes.
+     */
+    bool load(const string &file, float speed_scale);
+
+    int num_lanes() const { return this->widths.size(); }
+
+    float width(int lane) const { return this->widths[lane]; }
+
+    float center(int lane) const { return this->centers[lane]; }
+
+    // d of the inner border of lane; edge(num_lanes()) is the outer border of the road
+    float edge(int lane) const { return this->edges[lane]; }
+
+    float speed_limit(int lane) const { return this->speed_limits[lane]; }
+
+    // the highest limit of any lane
+    float max_speed_limit() const;
+
+    // lane containing d, -1 left of the road and num_lanes() right of it
+    int lane_at(float d) const;
+
+private:
+
+    vector<float> widths;
+    vector<float> speed_limits;
+    vector<float> centers;
+    vector<float> edges;
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include "thread_pool.h"
+#include <string>
+#include "frame_arena.h"
+#include "trace.h"
+
+ThreadPool planner_pool;
+
+ThreadPool::ThreadPool() {
+    this->generation = 0;
+    this->stopping = false;
+    this->task = NULL;
+    this->task_body = NULL;
+    this->busy = 0;
+    this->queues.reset(new Queue[1]);
+    this->queues[0].begin = 0;
+    this->queues[0].end = 0;
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+void ThreadPool::start(int threads) {
+    stop();
+    int participants = threads > 1 ? threads : 1;
+    this->queues.reset(new Queue[participants]);
+    for (int i = 0; i < participants; i++) {
+        this->queues[i].begin = 0;
+        this->queues[i].end = 0;
+    }
+    this->stopping = false;
+    for (int i = 0; i + 1 < participants; i++) {
+        this->threads.push_back(thread(&ThreadPool::worker_loop, this, i));
+    }
+}
+
+void ThreadPool::stop() {
+    {
+        lock_guard<mutex> guard(this->wake_lock);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for (size_t i = 0; i < this->threads.size(); i++) {
+        this->threads[i].join();
+    }
+    this->threads.clear();
+}
+
+void ThreadPool::run(int n, void (*fn)(void *, int), void *body) {
+    /*
+    Deals out contiguous index ranges, wakes the workers and joins in as the last participant.
+    Every worker is back waiting for the next generation before this returns, so nothing but
+    the caller touches the batch state between two calls, and the plain stores below are
+    published to the workers by the generation bump under wake_lock. The release decrement
+    of busy after each worker's last task publishes its results to the caller.
+    */
+    if (n <= 0) return;
+    if (this->threads.empty() || n == 1) {
+        for (int i = 0; i < n; i++) fn(body, i);
+        return;
+    }
+    int participants = size();
+    this->task = fn;
+    this->task_body = body;
+    for (int p = 0; p < participants; p++) {
+        lock_guard<mutex> guard(this->queues[p].lock);
+        this->queues[p].begin = (int) ((long) n*p/participants);
+        this->queues[p].end = (int) ((long) n*(p + 1)/participants);
+    }
+    {
+        lock_guard<mutex> guard(this->wake_lock);
+        this->busy.store(participants - 1, memory_order_relaxed);
+        this->generation++;
+    }
+    this->wake.notify_all();
+    drain(participants - 1);
+    while (this->busy.load(memory_order_acquire) > 0) {
+        this_thread::yield();
+    }
+}
+
+void ThreadPool::worker_loop(int self) {
+    tracer.set_thread_name("planner worker " + to_string(self));
+    uint64_t seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> guard(this->wake_lock);
+            this->wake.wait(guard, [&] { return this->stopping || this->generation != seen; });
+            if (this->stopping) return;
+            seen = this->generation;
+        }
+        // a new generation means the caller has started its next batch, so it is done with the last one
+        frame_arena.reset();
+        drain(self);
+        this->busy.fetch_sub(1, memory_order_release);
+    }
+}
+
+void ThreadPool::drain(int self) {
+    int task;
+    while (pop(self, task) || steal(self, task)) {
+        this->task(this->task_body, task);
+    }
+}
+
+bool ThreadPool::pop(int self, int &task) {
+    Queue &queue = this->queues[self];
+    lock_guard<mutex> guard(queue.lock);
+    if (queue.begin >= queue.end) return false;
+    task = queue.begin++;
+    return true;
+}
+
+bool ThreadPool::steal(int self, int &task) {
+    /*
+    Takes the back half of the first queue with work, starting after our own, runs its first
+    task and keeps the rest in our queue, where others can steal it in turn.
+    */
+    int participants = size();
+    for (int k = 1; k < participants; k++) {
+        Queue &victim = this->queues[(self + k) % participants];
+        int begin;
+        int end;
+        {
+            lock_guard<mutex> guard(victim.lock);
+            int left = victim.end - victim.begin;
+            if (left <= 0) continue;
+            end = victim.end;
+            begin = end - (left + 1)/2;
+            victim.end = begin;
+        }
+        task = begin;
+        Queue &queue = this->queues[self];
+        lock_guard<mutex> guard(queue.lock);
+        queue.begin = begin + 1;
+        queue.end = end;
+        return true;
+    }
+    return false;
+}
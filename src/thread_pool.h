@@ -0,0 +1,88 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Fork-join pool for the planner's data-parallel loops. parallel_for(n, body)
+ * runs body(0) .. body(n-1) across the workers and the calling thread and
+ * returns once every call has finished. The index range is split evenly into
+ * one queue per participant; a participant works through its own queue from
+ * the front and, once it is empty, steals the back half of another queue.
+ * Handing out a batch never touches the heap.
+ *
+ * parallel_for only returns once every worker has finished with the batch and
+ * gone back to waiting, so no worker runs a task or touches its arena between
+ * two batches. Every worker thread has its own frame arena, recycled when it
+ * picks up the caller's next batch: frame_vectors built by body stay valid
+ * until the caller starts that batch, so it must copy out what it keeps before.
+ * Calls do not nest, and only one thread may call parallel_for at a time.
+ */
+class ThreadPool {
+public:
+
+    /**
+    * Constructor
+    */
+    ThreadPool();
+
+    /**
+    * Destructor
+    */
+    virtual ~ThreadPool();
+
+    // runs parallel_for on threads threads, the caller included; 1 or less runs everything inline
+    void start(int threads);
+
+    // joins the workers
+    void stop();
+
+    // threads taking part in a batch, the caller included
+    int size() const { return this->threads.size() + 1; }
+
+    template <class F>
+    void parallel_for(int n, F &body) { run(n, &call<F>, &body); }
+
+private:
+
+    struct Queue {
+        mutex lock;
+        int begin;
+        int end;
+    };
+
+    template <class F>
+    static void call(void *body, int i) { (*(F *) body)(i); }
+
+    void run(int n, void (*fn)(void *, int), void *body);
+
+    void worker_loop(int self);
+
+    // runs tasks from queue self, then stolen ones, until no queue has work left
+    void drain(int self);
+
+    bool pop(int self, int &task);
+
+    bool steal(int self, int &task);
+
+    vector<thread> threads;
+    unique_ptr<Queue[]> queues; // one per participant, the caller's last
+    mutex wake_lock;
+    condition_variable wake;
+    uint64_t generation; // batches handed out, guarded by wake_lock
+    bool stopping;
+    void (*task)(void *, int);
+    void *task_body;
+    atomic<int> busy; // workers not done with the current batch yet
+};
+
+// pool of the behavior planner, inline until started
+extern ThreadPool planner_pool;
+
+#endif
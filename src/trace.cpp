@@ -0,0 +1,132 @@
+#include "trace.h"
+#include <chrono>
+#include <string.h>
+#include <unistd.h>
+
+Tracer tracer;
+
+static int64_t steady_us() {
+    return chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void copy_name(char *dst, const char *src) {
+    /*
+    Copies into a fixed-size event field, dropping characters that would need JSON escaping.
+    */
+    int n = 0;
+    if (src != NULL) {
+        for (; *src != '\0' && n < TRACE_NAME_LEN - 1; src++) {
+            if (*src != '"' && *src != '\\' && (unsigned char) *src >= 0x20) dst[n++] = *src;
+        }
+    }
+    dst[n] = '\0';
+}
+
+Tracer::Tracer() {
+    this->active = false;
+    this->epoch_us = steady_us();
+}
+
+Tracer::~Tracer() {
+    close();
+}
+
+bool Tracer::open(const string &path) {
+    close();
+    this->out.open(path.c_str(), ofstream::out | ofstream::trunc);
+    if (!this->out) return false;
+    // JSON array format: the closing bracket is optional, so events can be appended as they come
+    this->out << "[\n";
+    this->out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << getpid()
+              << ",\"tid\":0,\"args\":{\"name\":\"path_planning\"}},\n";
+    this->epoch_us = steady_us();
+    this->active = true;
+    return true;
+}
+
+int64_t Tracer::now_us() const {
+    return steady_us() - this->epoch_us;
+}
+
+Tracer::ThreadBuffer *Tracer::thread_buffer() {
+    static thread_local ThreadBuffer *buffer = NULL;
+    if (buffer == NULL) {
+        buffer = new ThreadBuffer();
+        buffer->name_written = false;
+        lock_guard<mutex> guard(this->registry_lock);
+        buffer->tid = this->buffers.size() + 1;
+        this->buffers.push_back(buffer);
+    }
+    return buffer;
+}
+
+void Tracer::add_event(const char *name, const char *arg, const char *cat, int64_t ts_us, int64_t dur_us) {
+    if (!this->active) return;
+    TraceEvent event;
+    copy_name(event.name, name);
+    copy_name(event.arg, arg);
+    event.cat = cat;
+    event.ts_us = ts_us;
+    event.dur_us = dur_us;
+    ThreadBuffer *buffer = thread_buffer();
+    lock_guard<mutex> guard(buffer->lock);
+    buffer->events.push_back(event);
+}
+
+void Tracer::set_thread_name(const string &name) {
+    if (!this->active) return;
+    ThreadBuffer *buffer = thread_buffer();
+    lock_guard<mutex> guard(buffer->lock);
+    buffer->thread_name = name;
+    buffer->name_written = false;
+}
+
+void Tracer::flush() {
+    if (!this->active) return;
+    int pid = getpid();
+    lock_guard<mutex> registry_guard(this->registry_lock);
+    for (size_t i = 0; i < this->buffers.size(); i++) {
+        ThreadBuffer *buffer = this->buffers[i];
+        lock_guard<mutex> guard(buffer->lock);
+        if (!buffer->name_written && !buffer->thread_name.empty()) {
+            char name[TRACE_NAME_LEN];
+            copy_name(name, buffer->thread_name.c_str());
+            this->out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << buffer->tid
+                      << ",\"args\":{\"name\":\"" << name << "\"}},\n";
+            buffer->name_written = true;
+        }
+        for (size_t j = 0; j < buffer->events.size(); j++) {
+            const TraceEvent &event = buffer->events[j];
+            this->out << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.cat
+                      << "\",\"ph\":\"X\",\"ts\":" << event.ts_us << ",\"dur\":" << event.dur_us
+                      << ",\"pid\":" << pid << ",\"tid\":" << buffer->tid;
+            if (event.arg[0] != '\0') {
+                this->out << ",\"args\":{\"detail\":\"" << event.arg << "\"}";
+            }
+            this->out << "},\n";
+        }
+        buffer->events.clear();
+    }
+    this->out.flush();
+}
+
+void Tracer::close() {
+    if (!this->active) return;
+    flush();
+    this->active = false;
+    this->out.close();
+}
+
+TraceScope::TraceScope(const char *name, const char *arg, const char *cat) {
+    this->name = name;
+    this->arg = arg;
+    this->cat = cat;
+    this->start_us = tracer.enabled() ? tracer.now_us() : 0;
+}
+
+TraceScope::~TraceScope() {
+    if (tracer.enabled()) {
+        tracer.add_event(this->name, this->arg, this->cat, this->start_us, tracer.now_us() - this->start_us);
+    }
+}
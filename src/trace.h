@@ -0,0 +1,93 @@
+#ifndef TRACE_H
+#define TRACE_H
+#include <fstream>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Optional timeline tracing in Chrome trace_event JSON format (loadable in
+ * chrome://tracing or ui.perfetto.dev). Disabled unless Tracer::open is called,
+ * in which case a TraceScope costs one branch.
+ */
+
+const int TRACE_NAME_LEN = 32;
+
+struct TraceEvent {
+    char name[TRACE_NAME_LEN];
+    char arg[TRACE_NAME_LEN]; // optional "detail" argument, empty if unused
+    const char *cat;
+    int64_t ts_us;
+    int64_t dur_us;
+};
+
+class Tracer {
+public:
+
+    /**
+    * Constructor
+    */
+    Tracer();
+
+    /**
+    * Destructor
+    */
+    virtual ~Tracer();
+
+    bool open(const string &path);
+
+    bool enabled() const { return this->active; }
+
+    // microseconds since the tracer was opened
+    int64_t now_us() const;
+
+    void add_event(const char *name, const char *arg, const char *cat, int64_t ts_us, int64_t dur_us);
+
+    // names the calling thread in the viewer
+    void set_thread_name(const string &name);
+
+    // appends every buffered event to the trace file
+    void flush();
+
+    void close();
+
+private:
+
+    struct ThreadBuffer {
+        int tid;
+        string thread_name;
+        bool name_written;
+        mutex lock;
+        vector<TraceEvent> events;
+    };
+
+    ThreadBuffer *thread_buffer();
+
+    bool active;
+    int64_t epoch_us;
+    ofstream out;
+    mutex registry_lock;
+    vector<ThreadBuffer *> buffers;
+};
+
+extern Tracer tracer;
+
+class TraceScope {
+public:
+
+    TraceScope(const char *name, const char *arg=NULL, const char *cat="planner");
+
+    ~TraceScope();
+
+private:
+
+    const char *name;
+    const char *arg;
+    const char *cat;
+    int64_t start_us;
+};
+
+#endif
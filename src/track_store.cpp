@@ -0,0 +1,104 @@
+#include "track_store.h"
+
+// process noise (jerk spectral density) and measurement noise of the filters
+const float LONG_JERK_NOISE = 2.0;
+const float LAT_JERK_NOISE = 0.5;
+const float S_NOISE = 0.25;
+const float SPEED_NOISE = 0.25;
+const float D_NOISE = 0.05;
+const float D_SPEED_NOISE = 0.1;
+// initial uncertainty of a new track
+const float INIT_POS_VAR = 1.0;
+const float INIT_VEL_VAR = 4.0;
+const float INIT_ACC_VAR = 4.0;
+
+TrackStore::TrackStore() {
+    this->loop_length = 0;
+}
+
+TrackStore::~TrackStore() {}
+
+void TrackStore::begin_frame(double dt) {
+    if (dt <= 0) return;
+    kalman_predict(this->long_filter, dt, LONG_JERK_NOISE);
+    kalman_predict(this->lat_filter, dt, LAT_JERK_NOISE);
+}
+
+int TrackStore::find(int id) const {
+    if (id < 0 || id >= (int) this->slot_of_id.size()) return -1;
+    return this->slot_of_id[id];
+}
+
+int TrackStore::allocate(int id) {
+    int slot;
+    if (!this->free_slots.empty()) {
+        slot = this->free_slots.back();
+        this->free_slots.pop_back();
+    } else {
+        slot = this->id.size();
+        this->id.push_back(-1);
+        this->s.push_back(0);
+        this->d.push_back(0);
+        this->v_s.push_back(0);
+        this->a_s.push_back(0);
+        this->d_dot.push_back(0);
+        this->missed.push_back(0);
+        this->z_s.push_back(0);
+        this->z_d.push_back(0);
+        this->z_s_dot.push_back(0);
+        this->z_d_dot.push_back(0);
+        this->measured.push_back(0);
+        this->long_filter.resize(slot + 1);
+        this->lat_filter.resize(slot + 1);
+    }
+    if (id >= (int) this->slot_of_id.size()) this->slot_of_id.resize(id + 1, -1);
+    this->slot_of_id[id] = slot;
+    this->id[slot] = id;
+    this->missed[slot] = 0;
+    return slot;
+}
+
+int TrackStore::update(int id, float s, float d, float s_dot, float d_dot) {
+    /*
+    A new track starts its filters at the measurement with zero acceleration. For a known
+    track the measurement is queued for end_frame.
+    */
+    if (id < 0) return -1;
+    int slot = find(id);
+    if (slot < 0) {
+        slot = allocate(id);
+        this->long_filter.init(slot, s, s_dot, INIT_POS_VAR, INIT_VEL_VAR, INIT_ACC_VAR);
+        this->lat_filter.init(slot, d, d_dot, INIT_POS_VAR, INIT_VEL_VAR, INIT_ACC_VAR);
+        this->measured[slot] = 0;
+    } else {
+        this->z_s[slot] = s;
+        this->z_d[slot] = d;
+        this->z_s_dot[slot] = s_dot;
+        this->z_d_dot[slot] = d_dot;
+        this->measured[slot] = 1;
+    }
+    this->missed[slot] = -1; // end_frame brings it back to 0
+    return slot;
+}
+
+void TrackStore::end_frame() {
+    kalman_update_pos_vel(this->long_filter, this->z_s.data(), this->z_s_dot.data(), this->measured.data(),
+                          S_NOISE, SPEED_NOISE, this->loop_length);
+    kalman_update_pos_vel(this->lat_filter, this->z_d.data(), this->z_d_dot.data(), this->measured.data(),
+                          D_NOISE, D_SPEED_NOISE, 0);
+
+    for (int slot = 0; slot < slots(); slot++) {
+        this->measured[slot] = 0;
+        if (this->id[slot] < 0) continue;
+        this->s[slot] = this->long_filter.x0[slot];
+        this->v_s[slot] = this->long_filter.x1[slot];
+        this->a_s[slot] = this->long_filter.x2[slot];
+        this->d[slot] = this->lat_filter.x0[slot];
+        this->d_dot[slot] = this->lat_filter.x1[slot];
+        if (++this->missed[slot] > TRACK_MAX_MISSED) {
+            this->slot_of_id[this->id[slot]] = -1;
+            this->id[slot] = -1;
+            this->free_slots.push_back(slot);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef TRACK_STORE_H
+#define TRACK_STORE_H
+#include <vector>
+#include "kalman.h"
+
+using namespace std;
+
+const int TRACK_MAX_MISSED = 5; // frames a track survives without a measurement
+
+/*
+ * Tracks of the surrounding vehicles keyed by the simulator's sensor fusion id,
+ * updated in place every frame. Each track runs a constant-acceleration Kalman
+ * filter along s and another along d; the filters of all tracks live in two SoA
+ * banks stepped together by the batch kernels in kalman.h. The latest estimates
+ * are exposed as columns. Slots are reused, so a steady-state frame does not allocate.
+ *
+ * Per frame: begin_frame(dt), update() for every measurement, end_frame().
+ */
+class TrackStore {
+public:
+
+    // one entry per slot; id is -1 for a free slot
+    vector<int> id;
+    vector<float> s;
+    vector<float> d;
+    vector<float> v_s;
+    vector<float> a_s;
+    vector<float> d_dot;
+    vector<int> missed; // frames since the last measurement
+
+    /**
+    * Constructor
+    */
+    TrackStore();
+
+    /**
+    * Destructor
+    */
+    virtual ~TrackStore();
+
+    // length of the s loop (the track length), 0 for an open road
+    void set_loop_length(float length) { this->loop_length = length; }
+
+    // predicts every track dt seconds ahead
+    void begin_frame(double dt);
+
+    // queues one measurement (position and Frenet speeds) for the track of sensor fusion id, creating it if needed; returns the slot
+    int update(int id, float s, float d, float s_dot, float d_dot);
+
+    // runs the batched measurement update, ages tracks that got no measurement and frees the stale ones
+    void end_frame();
+
+    int slots() const { return this->id.size(); }
+
+    // slot of a sensor fusion id, -1 if not tracked
+    int find(int id) const;
+
+private:
+
+    int allocate(int id);
+
+    float loop_length;
+    vector<int> slot_of_id; // direct-address table, simulator ids are small integers
+    vector<int> free_slots;
+    KalmanBank long_filter; // along s
+    KalmanBank lat_filter; // along d
+    vector<float> z_s; // this frame's measurements
+    vector<float> z_d;
+    vector<float> z_s_dot;
+    vector<float> z_d_dot;
+    vector<float> measured; // 1 if the slot got a measurement to fold in this frame
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include "traffic_table.h"
+
+TrafficTable::TrafficTable() {}
+
+TrafficTable::~TrafficTable() {}
+
+void TrafficTable::clear() {
+    this->id.clear();
+    this->lane.clear();
+    this->s.clear();
+    this->d.clear();
+    this->v_s.clear();
+    this->a_s.clear();
+    this->d_dot.clear();
+}
+
+void TrafficTable::reserve(int rows) {
+    this->id.reserve(rows);
+    this->lane.reserve(rows);
+    this->s.reserve(rows);
+    this->d.reserve(rows);
+    this->v_s.reserve(rows);
+    this->a_s.reserve(rows);
+    this->d_dot.reserve(rows);
+}
+
+void TrafficTable::retain(const uint8_t *keep) {
+    int rows = size();
+    int kept = 0;
+    for (int i = 0; i < rows; i++) {
+        if (!keep[i]) continue;
+        if (kept != i) {
+            this->id[kept] = this->id[i];
+            this->lane[kept] = this->lane[i];
+            this->s[kept] = this->s[i];
+            this->d[kept] = this->d[i];
+            this->v_s[kept] = this->v_s[i];
+            this->a_s[kept] = this->a_s[i];
+            this->d_dot[kept] = this->d_dot[i];
+        }
+        kept++;
+    }
+    this->id.resize(kept);
+    this->lane.resize(kept);
+    this->s.resize(kept);
+    this->d.resize(kept);
+    this->v_s.resize(kept);
+    this->a_s.resize(kept);
+    this->d_dot.resize(kept);
+}
+
+int TrafficTable::add(int id, int lane, float s, float d, float v_s, float a_s, float d_dot) {
+    this->id.push_back(id);
+    this->lane.push_back(lane);
+    this->s.push_back(s);
+    this->d.push_back(d);
+    this->v_s.push_back(v_s);
+    this->a_s.push_back(a_s);
+    this->d_dot.push_back(d_dot);
+    return this->id.size() - 1;
+}
+
+Vehicle TrafficTable::vehicle(int i) const {
+    return Vehicle(this->lane[i], this->s[i], this->d[i], this->v_s[i], this->a_s[i], State::CS);
+}
+
+MotionModel TrafficTable::motion_model(int i) const {
+    MotionModel model = {this->s[i], this->v_s[i], this->a_s[i], this->d[i], this->d_dot[i],
+                         (int16_t) this->lane[i], MOTION_CONSTANT_ACCELERATION};
+    return model;
+}
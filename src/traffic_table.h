@@ -0,0 +1,57 @@
+#ifndef TRAFFIC_TABLE_H
+#define TRAFFIC_TABLE_H
+#include <stdint.h>
+#include <vector>
+#include "motion_model.h"
+#include "vehicle.h"
+
+using namespace std;
+
+/*
+ * Flat struct-of-arrays table of the surrounding traffic (the ego lives in a
+ * separate slot in Road). Rows are rebuilt every frame, but clear() keeps the
+ * column capacity, so a steady-state frame does not touch the heap and scans
+ * walk contiguous columns.
+ */
+class TrafficTable {
+public:
+
+    vector<int> id;
+    vector<int> lane;
+    vector<float> s;
+    vector<float> d;
+    vector<float> v_s;
+    vector<float> a_s;
+    vector<float> d_dot; // lateral speed, positive away from the center line
+
+    /**
+    * Constructor
+    */
+    TrafficTable();
+
+    /**
+    * Destructor
+    */
+    virtual ~TrafficTable();
+
+    int size() const { return this->id.size(); }
+
+    void clear();
+
+    void reserve(int rows);
+
+    // drops every row i with keep[i] == 0, keeping the order of the others
+    void retain(const uint8_t *keep);
+
+    // appends a row and returns its index
+    int add(int id, int lane, float s, float d, float v_s, float a_s, float d_dot);
+
+    // materializes row i as a Vehicle
+    Vehicle vehicle(int i) const;
+
+    // constant acceleration model of row i, for prediction
+    MotionModel motion_model(int i) const;
+
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "trajectory_generator.h"
+
+TrajectoryGenerator::TrajectoryGenerator() {}
+
+TrajectoryGenerator::~TrajectoryGenerator() {}
+
+int TrajectoryGenerator::samples(const RoadModel &model) const {
+    return model.num_lanes()*this->params.num_speeds*this->params.num_durations;
+}
+
+void TrajectoryGenerator::generate(const double *s_start, const double *d_start, const RoadModel &model, TrajectorySet &out) {
+    /*
+    Samples are laid out by duration, then lane, then speed. The s end position is
+    s0 + (v0 + v1)/2*T; d ends on the lane center with no lateral speed or acceleration.
+    */
+    const SamplingParams &p = this->params;
+    this->durations.resize(p.num_durations);
+    for (int ti = 0; ti < p.num_durations; ti++) {
+        this->durations[ti] = p.num_durations > 1 ? p.min_duration + (p.max_duration - p.min_duration)*ti/(p.num_durations - 1)
+                                                  : p.max_duration;
+    }
+    this->solver.set_durations(this->durations.data(), p.num_durations);
+
+    int batch = model.num_lanes()*p.num_speeds;
+    this->end_s.resize(batch);
+    this->end_v.resize(batch);
+    this->end_d.resize(batch);
+    this->end_zero.assign(batch, 0);
+    out.clear();
+    out.reserve(samples(model));
+    for (int ti = 0; ti < p.num_durations; ti++) {
+        float T = this->durations[ti];
+        int first = out.size();
+        for (int lane = 0; lane < model.num_lanes(); lane++) {
+            float limit = model.speed_limit(lane);
+            for (int si = 0; si < p.num_speeds; si++) {
+                float ratio = p.num_speeds > 1 ? p.min_speed_ratio + (1 - p.min_speed_ratio)*si/(p.num_speeds - 1) : 1;
+                float v = limit*ratio;
+                int j = out.add(lane, model.center(lane), v, T) - first;
+                this->end_s[j] = s_start[0] + (s_start[1] + v)/2*T;
+                this->end_v[j] = v;
+                this->end_d[j] = model.center(lane);
+            }
+        }
+        double *s_coef[QUINTIC_COEFFS];
+        double *d_coef[QUINTIC_COEFFS];
+        for (int k = 0; k < QUINTIC_COEFFS; k++) {
+            s_coef[k] = out.s_coef[k].data() + first;
+            d_coef[k] = out.d_coef[k].data() + first;
+        }
+        this->solver.solve(ti, s_start, this->end_s.data(), this->end_v.data(), this->end_zero.data(), batch, s_coef);
+        this->solver.solve(ti, d_start, this->end_d.data(), this->end_zero.data(), this->end_zero.data(), batch, d_coef);
+    }
+}
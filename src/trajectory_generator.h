@@ -0,0 +1,63 @@
+#ifndef TRAJECTORY_GENERATOR_H
+#define TRAJECTORY_GENERATOR_H
+#include <vector>
+#include "jmt_solver.h"
+#include "road_model.h"
+#include "trajectory_set.h"
+
+using namespace std;
+
+/*
+ * End-state grid of the trajectory sampler. Every lane center is a target d; the
+ * target speeds run evenly from min_speed_ratio of the lane's speed limit up to
+ * the limit, and the durations evenly from min_duration to max_duration.
+ */
+struct SamplingParams {
+    int num_speeds = 10;
+    float min_speed_ratio = 0.3;
+    int num_durations = 8;
+    float min_duration = 1.5; // s
+    float max_duration = 4.0; // s
+};
+
+/*
+ * Samples end states over target lane, speed and duration and fits a pair of
+ * quintics from the start state to each of them. The end state comes to rest
+ * laterally on the lane center and longitudinally at the target speed with no
+ * acceleration, having covered the distance of a constant-acceleration ramp from
+ * the start speed to the target speed. Rows are laid out duration-major, so the
+ * samples of one duration are solved as one JmtSolver batch.
+ */
+class TrajectoryGenerator {
+public:
+
+    SamplingParams params;
+
+    /**
+    * Constructor
+    */
+    TrajectoryGenerator();
+
+    /**
+    * Destructor
+    */
+    virtual ~TrajectoryGenerator();
+
+    // number of samples generate() produces on model
+    int samples(const RoadModel &model) const;
+
+    /*
+     * Replaces out with one trajectory per sample. s_start and d_start are the
+     * position, speed and acceleration of the start state along s and along d.
+     */
+    void generate(const double *s_start, const double *d_start, const RoadModel &model, TrajectorySet &out);
+
+private:
+
+    JmtSolver solver;
+    vector<float> durations;
+    // end states of one duration's batch
+    vector<double> end_s, end_v, end_d, end_zero;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#include "trajectory_set.h"
+
+TrajectorySet::TrajectorySet() {}
+
+TrajectorySet::~TrajectorySet() {}
+
+void TrajectorySet::clear() {
+    this->lane.clear();
+    this->target_d.clear();
+    this->target_v.clear();
+    this->T.clear();
+    for (int k = 0; k < QUINTIC_COEFFS; k++) {
+        this->s_coef[k].clear();
+        this->d_coef[k].clear();
+    }
+}
+
+void TrajectorySet::reserve(int rows) {
+    this->lane.reserve(rows);
+    this->target_d.reserve(rows);
+    this->target_v.reserve(rows);
+    this->T.reserve(rows);
+    for (int k = 0; k < QUINTIC_COEFFS; k++) {
+        this->s_coef[k].reserve(rows);
+        this->d_coef[k].reserve(rows);
+    }
+}
+
+int TrajectorySet::add(int lane, float target_d, float target_v, float T) {
+    this->lane.push_back(lane);
+    this->target_d.push_back(target_d);
+    this->target_v.push_back(target_v);
+    this->T.push_back(T);
+    for (int k = 0; k < QUINTIC_COEFFS; k++) {
+        this->s_coef[k].push_back(0);
+        this->d_coef[k].push_back(0);
+    }
+    return size() - 1;
+}
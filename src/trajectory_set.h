@@ -0,0 +1,77 @@
+#ifndef TRAJECTORY_SET_H
+#define TRAJECTORY_SET_H
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+const int QUINTIC_COEFFS = 6;
+
+/*
+ * Flat struct-of-arrays buffer of candidate trajectories, one row per sampled end
+ * state. Each row holds the sample (target lane, d, speed, duration T) and the
+ * quintics s(t) = sum_k s_coef[k][i] t^k and d(t) = sum_k d_coef[k][i] t^k for
+ * t in [0, T], with t = 0 at the start state. Coefficient k of every row is one
+ * contiguous column, so batch checks and costs stream over all rows at once.
+ * clear() keeps the capacity of every column.
+ */
+class TrajectorySet {
+public:
+
+    vector<int16_t> lane;
+    vector<float> target_d;
+    vector<float> target_v;
+    vector<float> T;
+    vector<double> s_coef[QUINTIC_COEFFS];
+    vector<double> d_coef[QUINTIC_COEFFS];
+
+    /**
+    * Constructor
+    */
+    TrajectorySet();
+
+    /**
+    * Destructor
+    */
+    virtual ~TrajectorySet();
+
+    int size() const { return this->T.size(); }
+
+    void clear();
+
+    void reserve(int rows);
+
+    // appends a sample with zero coefficients and returns its index
+    int add(int lane, float target_d, float target_v, float T);
+
+    double s_at(int i, double t) const { return eval(this->s_coef, i, t); }
+
+    double d_at(int i, double t) const { return eval(this->d_coef, i, t); }
+
+    // speed and acceleration along s
+    double s_dot_at(int i, double t) const { return eval_dot(this->s_coef, i, t); }
+
+    double s_ddot_at(int i, double t) const { return eval_ddot(this->s_coef, i, t); }
+
+private:
+
+    static double eval(const vector<double> *coef, int i, double t) {
+        double value = coef[QUINTIC_COEFFS - 1][i];
+        for (int k = QUINTIC_COEFFS - 2; k >= 0; k--) value = value*t + coef[k][i];
+        return value;
+    }
+
+    static double eval_dot(const vector<double> *coef, int i, double t) {
+        double value = (QUINTIC_COEFFS - 1)*coef[QUINTIC_COEFFS - 1][i];
+        for (int k = QUINTIC_COEFFS - 2; k >= 1; k--) value = value*t + k*coef[k][i];
+        return value;
+    }
+
+    static double eval_ddot(const vector<double> *coef, int i, double t) {
+        double value = (QUINTIC_COEFFS - 1)*(QUINTIC_COEFFS - 2)*coef[QUINTIC_COEFFS - 1][i];
+        for (int k = QUINTIC_COEFFS - 2; k >= 2; k--) value = value*t + k*(k - 1)*coef[k][i];
+        return value;
+    }
+};
+
+#endif
@@ -8,6 +8,36 @@
 #include <string>
 #include <iterator>
 #include "cost.h"
+#include "prediction_store.h"
+#include "road_model.h"
+#include "trace.h"
+#include "thread_pool.h"
+
+// a lane change is ruled out when vehicles are expected in the target spot with at least this probability
+const float LANE_CHANGE_MAX_RISK = 0.5;
+
+static const char *STATE_NAMES[NUM_STATES] = {"CS", "KL", "LCL", "LCR", "PLCL", "PLCR", "LCL2", "LCR2"};
+
+struct Transitions {
+    int count;
+    State next[MAX_SUCCESSORS];
+};
+
+// candidate successors of every state, in evaluation order; the ones that would leave the road are dropped
+static const Transitions TRANSITIONS[NUM_STATES] = {
+    {1, {State::KL}}, // CS
+    {7, {State::KL, State::LCR, State::LCL, State::PLCR, State::PLCL, State::LCR2, State::LCL2}}, // KL
+    {1, {State::KL}}, // LCL
+    {1, {State::KL}}, // LCR
+    {4, {State::KL, State::PLCL, State::LCL, State::LCL2}}, // PLCL
+    {4, {State::KL, State::PLCR, State::LCR, State::LCR2}}, // PLCR
+    {1, {State::KL}}, // LCL2
+    {1, {State::KL}}, // LCR2
+};
+
+const char *state_name(State state) {
+    return STATE_NAMES[(int) state];
+}
 
 /**
  * Initializes Vehicle
@@ -15,7 +45,7 @@
 
 Vehicle::Vehicle(){}
 
-Vehicle::Vehicle(int lane, float s,float d, float v_s,float a_s, string state,int target_lane) {
+Vehicle::Vehicle(int lane, float s,float d, float v_s,float a_s, State state,int target_lane) {
 
     this->lane = lane;
     this->s = s;
@@ -26,81 +56,123 @@ Vehicle::Vehicle(int lane, float s,float d, float v_s,float a_s, string state,in
     this->target_lane=target_lane;
 }
 
-Vehicle::~Vehicle() {}
-
 
-vector<Vehicle> Vehicle::choose_next_state(map<int, vector<Vehicle>> predictions,float time_window) {
+frame_vector<Vehicle> Vehicle::choose_next_state(const PredictionStore &predictions,float time_window, decision *log) {
     /*
     Here you can implement the transition_function code from the Behavior Planning Pseudocode
     classroom concept. Your goal will be to return the best (lowest cost) trajectory corresponding
     to the next state.
 
-    INPUT: A predictions map. This is a map of vehicle id keys with predicted
-        vehicle trajectories as values. Trajectories are a vector of Vehicle objects representing
-        the vehicle at the current timestep and one timestep in the future.
-    OUTPUT: The the best (lowest cost) trajectory corresponding to the next ego vehicle state.
+    INPUT: The per-frame prediction store, holding for every other vehicle its predicted
+        states at the current timestep and the following ones.
+    OUTPUT: The the best (lowest cost) trajectory corresponding to the next ego vehicle state, empty
+    if no successor state produced one.
+    If log is given, it receives every evaluated state with its cost and the chosen index.
+
+    The candidates are generated and costed on planner_pool, each into its own slot; the
+    reduction then walks the slots in successor order on this thread, so the choice and the
+    log are the same as evaluating the states one after another.
     */
-    vector<string> states = successor_states();
+    frame_vector<State> states = successor_states();
 
-    float cost;
-    vector<float> costs;
-    vector<vector<Vehicle>> final_trajectories;
+    struct Candidate {
+        frame_vector<Vehicle> trajectory; // built in the arena of the thread that evaluated it
+        float cost;
+    };
+    frame_vector<Candidate> candidates(states.size());
     float max_dist=this->goal_s;
-    for (vector<string>::iterator it = states.begin(); it != states.end(); ++it) {
-        vector<Vehicle> trajectory = generate_trajectory(*it, predictions,time_window);
-        if (trajectory.size() >1) {
-            cost = calculate_cost(trajectory,max_dist);
-            costs.push_back(cost);
-            final_trajectories.push_back(trajectory);
+    auto evaluate = [&](int i) {
+        TraceScope trace("candidate", state_name(states[i]));
+        candidates[i].trajectory = generate_trajectory(states[i], predictions,time_window);
+        if (candidates[i].trajectory.size() >1) {
+            candidates[i].cost = calculate_cost(candidates[i].trajectory,max_dist,predictions,time_window);
         }
+    };
+    planner_pool.parallel_for(states.size(), evaluate);
+
+    frame_vector<float> costs;
+    int best_candidate = -1;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (candidates[i].trajectory.size() >1) {
+            if (best_candidate < 0 || candidates[i].cost < candidates[best_candidate].cost) best_candidate = i;
+            costs.push_back(candidates[i].cost);
+            if (log) log->states.push_back(states[i]);
+        }
+    }
+    if (best_candidate < 0) {
+        // no successor produced a trajectory: the caller keeps the current state
+        if (log) log->best = -1;
+        return frame_vector<Vehicle>();
     }
-    vector<float>::iterator best_cost = min_element(begin(costs), end(costs));
+    frame_vector<float>::iterator best_cost = min_element(begin(costs), end(costs));
 
     int best_idx = distance(begin(costs), best_cost);
-    return final_trajectories[best_idx];
+    if (log) {
+        log->costs.assign(costs.begin(), costs.end());
+        log->best = best_idx;
+    }
+    // copied into this thread's arena, the workers recycle theirs with the next batch
+    const frame_vector<Vehicle> &best = candidates[best_candidate].trajectory;
+    return frame_vector<Vehicle>(best.begin(), best.end());
 }
 
-vector<string> Vehicle::successor_states() {
+frame_vector<State> Vehicle::successor_states() {
     /*
     Provides the possible next states given the current state for the FSM
     discussed in the course, with the exception that lane changes happen
-    instantaneously, so LCL and LCR can only transition back to KL.
+    instantaneously, so LCL, LCR, LCL2 and LCR2 can only transition back to KL.
+    KL may also change lanes without preparing first, and a prepared change may
+    go one or two lanes. States whose target lane is off the road are left out.
     */
-    vector<string> states;
-    states.push_back("KL");
-    string state = this->state;
-    if(state.compare("KL") == 0 && this->lane<2){
-        states.push_back("LCR");
-    }
-    if(state.compare("KL") == 0 && this->lane>0){
-    	states.push_back("LCL");
+    const Transitions &transitions = TRANSITIONS[(int) this->state];
+    frame_vector<State> states;
+    states.reserve(transitions.count);
+    for (int i = 0; i < transitions.count; i++) {
+        int target = this->lane + lane_direction(transitions.next[i]);
+        if (target >= 0 && target < this->lanes_available) states.push_back(transitions.next[i]);
     }
-    //If state is "LCL" or "LCR", then just return "KL"
     return states;
 }
 
-vector<Vehicle> Vehicle::generate_trajectory(string state, map<int, vector<Vehicle>> predictions,float time_window) {
+frame_vector<Vehicle> Vehicle::generate_trajectory(State state, const PredictionStore &predictions,float time_window) {
     /*
     Given a possible next state, generate the appropriate trajectory to realize the next state.
     */
-    vector<Vehicle> trajectory;
-    if (state.compare("CS") == 0) {
+    frame_vector<Vehicle> trajectory;
+    switch (state) {
+    case State::CS:
         trajectory = constant_speed_trajectory(time_window);
-    } else if (state.compare("KL") == 0) {
+        break;
+    case State::KL:
         trajectory = keep_lane_trajectory(predictions,time_window);
-    } else if (state.compare("LCL") == 0 || state.compare("LCR") == 0) {
+        break;
+    case State::LCL:
+    case State::LCR:
+    case State::LCL2:
+    case State::LCR2:
         trajectory = lane_change_trajectory(state, predictions,time_window);
-    } else if (state.compare("PLCL") == 0 || state.compare("PLCR") == 0) {
+        break;
+    case State::PLCL:
+    case State::PLCR:
         trajectory = prep_lane_change_trajectory(state, predictions,time_window);
+        break;
+    }
+    // the states carry the ego's configuration, which the cost terms measure them against
+    for (size_t i = 0; i < trajectory.size(); i++) {
+        trajectory[i].target_speed = this->target_speed;
+        trajectory[i].lanes_available = this->lanes_available;
+        trajectory[i].goal_s = this->goal_s;
+        trajectory[i].max_acceleration = this->max_acceleration;
+        trajectory[i].road_model = this->road_model;
     }
     return trajectory;
 }
 
-vector<float> Vehicle::get_kinematics(map<int, vector<Vehicle>> predictions, int lane,float time_window) {
+frame_vector<float> Vehicle::get_kinematics(const PredictionStore &predictions, int lane,float time_window) {
     /*
     Gets next timestep kinematics (position, velocity, acceleration) for a given lane.
     Tries to choose the maximum velocity and acceleration,
-    given other vehicle positions and accel/velocity constraints.
+    given other vehicle positions, accel/velocity constraints and the lane's speed limit.
     */
 
     float max_pos_vel = this->max_acceleration*time_window + this->v_s;
@@ -110,8 +182,8 @@ vector<float> Vehicle::get_kinematics(map<int, vector<Vehicle>> predictions, int
     float new_accel;
     Vehicle vehicle_ahead;
     Vehicle vehicle_behind;
-    vector<double>  ahead=get_vehicle_ahead(predictions, vehicle_ahead,lane);
-    //vector<double>  behind=get_vehicle_behind(predictions, vehicle_behind,lane);
+    frame_vector<double>  ahead=get_vehicle_ahead(predictions, vehicle_ahead,lane);
+    //frame_vector<double>  behind=get_vehicle_behind(predictions, vehicle_behind,lane);
     if (ahead[0] && max_pos_vel>vehicle_ahead.v_s) {
         new_velocity = max(vehicle_ahead.v_s,max_neg_vel); //must travel at the speed of traffic, regardless of preferred buffer
         new_position = this->s + new_velocity*time_window - 0.5*this->max_acceleration*time_window*time_window;
@@ -123,7 +195,7 @@ vector<float> Vehicle::get_kinematics(map<int, vector<Vehicle>> predictions, int
             new_velocity = min(min(max_velocity_in_front, max_velocity_accel_limit), this->target_speed);
         }*/
     } else {
-        new_velocity = min(max_pos_vel, this->target_speed);
+        new_velocity = min(max_pos_vel, min(this->target_speed, this->road_model->speed_limit(lane)));
         new_position = this->s + new_velocity*time_window + 0.5*this->max_acceleration*time_window*time_window;
         //new_velocity = this->target_speed;
     }
@@ -132,30 +204,30 @@ vector<float> Vehicle::get_kinematics(map<int, vector<Vehicle>> predictions, int
     return{new_position, new_velocity, new_accel,ahead[0],ahead[1]};
 }
 
-vector<Vehicle> Vehicle::constant_speed_trajectory(float time_window) {
+frame_vector<Vehicle> Vehicle::constant_speed_trajectory(float time_window) {
     /*
     Generate a constant speed trajectory.
     */
     float next_pos_s = s_position_at(time_window);
-    vector<Vehicle> trajectory = {Vehicle(this->lane, this->s,this->d, this->v_s,0,this->state,this->target_lane),
+    frame_vector<Vehicle> trajectory = {Vehicle(this->lane, this->s,this->d, this->v_s,0,this->state,this->target_lane),
                                   Vehicle(this->lane, next_pos_s, this->d, this->v_s,0, this->state,this->target_lane)};
     return trajectory;
 }
 
-vector<Vehicle> Vehicle::keep_lane_trajectory(map<int, vector<Vehicle>> predictions,float time_window) {
+frame_vector<Vehicle> Vehicle::keep_lane_trajectory(const PredictionStore &predictions,float time_window) {
     /*
     Generate a keep lane trajectory.
     */
-    vector<Vehicle> trajectory = {Vehicle(this->lane, this->s,this->d, this->v_s, this->a_s,this->state,this->target_lane)};
-    vector<float> kinematics = get_kinematics(predictions, this->lane,time_window);
+    frame_vector<Vehicle> trajectory = {Vehicle(this->lane, this->s,this->d, this->v_s, this->a_s,this->state,this->target_lane)};
+    frame_vector<float> kinematics = get_kinematics(predictions, this->lane,time_window);
     float new_s = kinematics[0];
     float new_v = kinematics[1];
     float new_a = kinematics[2];
-    trajectory.push_back(Vehicle(this->lane, new_s,this->lane*4+2, new_v, new_a,"KL",this->lane));
+    trajectory.push_back(Vehicle(this->lane, new_s,this->road_model->center(this->lane), new_v, new_a,State::KL,this->lane));
     return trajectory;
 }
 
-vector<Vehicle> Vehicle::prep_lane_change_trajectory(string state, map<int, vector<Vehicle>> predictions,float time_window) {
+frame_vector<Vehicle> Vehicle::prep_lane_change_trajectory(State state, const PredictionStore &predictions,float time_window) {
     /*
     Generate a trajectory preparing for a lane change.
     */
@@ -163,9 +235,9 @@ vector<Vehicle> Vehicle::prep_lane_change_trajectory(string state, map<int, vect
     float new_v;
     float new_a;
     Vehicle vehicle_behind;
-    int new_lane = this->lane + lane_direction[state];
-    vector<Vehicle> trajectory = {Vehicle(this->lane, this->s,this->d, this->v_s, this->a_s,this->state,this->target_lane)};
-    vector<float> curr_lane_new_kinematics = get_kinematics(predictions, this->lane,time_window);
+    int new_lane = this->lane + lane_direction(state);
+    frame_vector<Vehicle> trajectory = {Vehicle(this->lane, this->s,this->d, this->v_s, this->a_s,this->state,this->target_lane)};
+    frame_vector<float> curr_lane_new_kinematics = get_kinematics(predictions, this->lane,time_window);
 
     if (get_vehicle_behind(predictions, vehicle_behind,lane)[0]) {
         //Keep speed of current lane so as not to collide with car behind.
@@ -174,8 +246,8 @@ vector<Vehicle> Vehicle::prep_lane_change_trajectory(string state, map<int, vect
         new_a = curr_lane_new_kinematics[2];
 
     } else {
-        vector<float> best_kinematics;
-        vector<float> next_lane_new_kinematics = get_kinematics(predictions, new_lane,time_window);
+        frame_vector<float> best_kinematics;
+        frame_vector<float> next_lane_new_kinematics = get_kinematics(predictions, new_lane,time_window);
         //Choose kinematics with lowest velocity.
         if (next_lane_new_kinematics[1] < curr_lane_new_kinematics[1]) {
             best_kinematics = next_lane_new_kinematics;
@@ -191,34 +263,28 @@ vector<Vehicle> Vehicle::prep_lane_change_trajectory(string state, map<int, vect
     return trajectory;
 }
 
-vector<Vehicle> Vehicle::lane_change_trajectory(string state, map<int, vector<Vehicle>> predictions,float time_window) {
+frame_vector<Vehicle> Vehicle::lane_change_trajectory(State state, const PredictionStore &predictions,float time_window) {
     /*
-    Generate a lane change trajectory.
+    Generate a lane change trajectory, over one or two lanes.
     */
-    int new_lane = this->lane + lane_direction[state];
-    float future_s=this->s_position_at(time_window);
-    bool car_ahead=false;
-    bool car_behind=false;
-    vector<Vehicle> trajectory;
-    Vehicle next_lane_vehicle;
-    //Check if a lane change is possible (check if another vehicle occupies that spot).
-    for (map<int, vector<Vehicle>>::iterator it = predictions.begin(); it != predictions.end(); ++it) {
-        next_lane_vehicle = it->second[0];
-        car_ahead=(next_lane_vehicle.s - future_s) < 5 && next_lane_vehicle.s > future_s && next_lane_vehicle.lane == new_lane;
-        if (car_ahead) break;
-    }
-    for (map<int, vector<Vehicle>>::iterator it = predictions.begin(); it != predictions.end(); ++it) {
-        next_lane_vehicle = it->second[0];
-        car_behind=(future_s-next_lane_vehicle.s) < 5 && next_lane_vehicle.s < future_s && next_lane_vehicle.lane == new_lane;
-        if (car_behind) break;
-    }
-    if(car_behind || car_ahead){
-    	return trajectory;
+    int direction = lane_direction(state) > 0 ? 1 : -1;
+    int new_lane = this->lane + lane_direction(state);
+    frame_vector<Vehicle> trajectory;
+    //Check if a lane change is possible (check if another vehicle is likely to occupy the ego's spot in any lane crossed, at any time bin of the maneuver).
+    const OccupancyGrid &occupancy = predictions.occupancy();
+    for (int b = 0; b*occupancy.time_step <= time_window + 1e-3f; b++) {
+        float t = b*occupancy.time_step;
+        float future_s = this->s_position_at(t);
+        for (int lane = this->lane + direction; lane != new_lane + direction; lane += direction) {
+            if(occupancy.mass(lane,future_s-5,future_s+5,t)>=LANE_CHANGE_MAX_RISK){
+            	return trajectory;
+            }
+        }
     }
     trajectory.push_back(Vehicle(this->lane, this->s,this->d, this->v_s, this->a_s,this->state,this->target_lane));
-    vector<float> kinematics = get_kinematics(predictions, new_lane,time_window);
-    float new_d = new_lane*4+2;
-    //float new_d = this->d +lane_direction[state];
+    frame_vector<float> kinematics = get_kinematics(predictions, new_lane,time_window);
+    float new_d = this->road_model->center(new_lane);
+    //float new_d = this->d +lane_direction(state);
     trajectory.push_back(Vehicle(new_lane, kinematics[0],new_d, kinematics[1], kinematics[2],state,new_lane));
     return trajectory;
 }
@@ -228,7 +294,7 @@ void Vehicle::s_increment(float dt = 1) {
 }
 
 float Vehicle::s_position_at(float t) {
-    return this->s + this->v_s*t + this->max_acceleration*t*t/2.0;
+    return this->s + this->v_s*t + this->a_s*t*t/2.0;
 }
 
 float Vehicle::s_speed_at(float t) {
@@ -236,76 +302,45 @@ float Vehicle::s_speed_at(float t) {
 }
 
 
-vector<double> Vehicle::get_vehicle_behind(map<int, vector<Vehicle>> predictions, Vehicle & rVehicle,int lane) {
+frame_vector<double> Vehicle::get_vehicle_behind(const PredictionStore &predictions, Vehicle & rVehicle,int lane) {
     /*
-    Returns a true if a vehicle is found behind the current vehicle, false otherwise. The passed reference
-    rVehicle is updated if a vehicle is found.
+    Returns a true if a vehicle is found behind the current vehicle in lane, false otherwise. The passed reference
+    rVehicle is updated with the nearest such vehicle.
     */
-    int max_s = -1;
-    bool found_vehicle = false;
-    Vehicle temp_vehicle;
-    double delta_s=this->s-max_s;
-    for (map<int, vector<Vehicle>>::iterator it = predictions.begin(); it != predictions.end(); ++it) {
-        temp_vehicle = it->second[0];
-        int v_id=it->first;
-        if (temp_vehicle.lane == this->lane && temp_vehicle.s < this->s && temp_vehicle.s > max_s) {
-            max_s = temp_vehicle.s;
-            rVehicle = temp_vehicle;
-            found_vehicle = true;
-        }
+    int nearest = predictions.neighbours().nearest_behind(lane, this->s);
+    bool found_vehicle = nearest >= 0;
+    if (found_vehicle) {
+        rVehicle = predictions.state_at(nearest, 0);
     }
-    return {found_vehicle};
+    return {(double) found_vehicle};
 }
 
-vector<double> Vehicle::get_vehicle_ahead(map<int, vector<Vehicle>> predictions, Vehicle & rVehicle,int lane) {
+frame_vector<double> Vehicle::get_vehicle_ahead(const PredictionStore &predictions, Vehicle & rVehicle,int lane) {
     /*
-    Returns a true if a vehicle is found ahead of the current vehicle, false otherwise. The passed reference
-    rVehicle is updated if a vehicle is found.
+    Returns a true if a vehicle is found less than 30m ahead of the current vehicle in lane, false otherwise.
+    The passed reference rVehicle is updated with the nearest such vehicle. Also returns its distance and speed.
     */
-    int min_s = this->goal_s;
     bool found_vehicle = false;
     float vehicle_speed=0;
-    Vehicle temp_vehicle;
-    double delta_s=min_s-this->s;
-    for (map<int, vector<Vehicle>>::iterator it = predictions.begin(); it != predictions.end(); ++it) {
-    	int v_id = it->first;
-        temp_vehicle = it->second[0];
+    double delta_s=0;
+    // any vehicle whose footprint reaches into the lane, not only the ones whose center is in it
+    int nearest = -1;
+    if (lane >= 0 && lane < this->road_model->num_lanes()) {
+        nearest = predictions.neighbours().nearest_ahead(lane, this->s, this->road_model->edge(lane), this->road_model->edge(lane + 1), 30);
+    }
+    if (nearest >= 0 && predictions.id(nearest) != -1) {
+        Vehicle temp_vehicle = predictions.state_at(nearest, 0);
         delta_s=temp_vehicle.s - this->s;
+        // past the end of the loop
+        if (delta_s<=0) delta_s+=this->goal_s;
         vehicle_speed=temp_vehicle.v_s;
-    	if(v_id  != -1 && temp_vehicle.lane == lane && delta_s > 0 && delta_s<30){
-            rVehicle = temp_vehicle;
-            found_vehicle = true;
-            break;
-    	}
+        rVehicle = temp_vehicle;
+        found_vehicle = true;
     }
-    return {found_vehicle,delta_s,vehicle_speed};
-}
-
-vector<Vehicle> Vehicle::generate_predictions(float horizon) {
-    /*
-    Generates predictions for non-ego vehicles to be used
-    in trajectory generation for the ego vehicle.
-    */
-	vector<Vehicle> predictions;
-    for(int i = 0; i < horizon; i++) {
-      float next_s = s_position_at(i);
-
-      float next_v_s = 0;
-      if (i < horizon-1) {
-        next_v_s = s_position_at(i+1) - next_s;
-      }
-
-      float next_a_s=0;
-      if (i < horizon-2) {
-        next_a_s = s_speed_at(i+1) - next_v_s;
-      }
-      predictions.push_back(Vehicle(this->lane, next_s,this->d, next_v_s,next_a_s,this->state,this->target_lane));
-  	}
-    return predictions;
-
+    return {(double) found_vehicle,delta_s,vehicle_speed};
 }
 
-void Vehicle::realize_next_state(vector<Vehicle> trajectory) {
+void Vehicle::realize_next_state(const frame_vector<Vehicle> &trajectory) {
     /*
     Sets state and kinematics for ego vehicle using the last state of the trajectory.
     */
@@ -319,7 +354,7 @@ void Vehicle::realize_next_state(vector<Vehicle> trajectory) {
     this->a_s = next_state.a_s;
 }
 
-void Vehicle::configure(vector<float> road_data) {
+void Vehicle::configure(const float *road_data) {
     /*
     Called by simulator before simulation begins. Sets various
     parameters which will impact the ego vehicle.
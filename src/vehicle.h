@@ -5,14 +5,36 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <stdint.h>
+#include <type_traits>
+#include "frame_arena.h"
 
 using namespace std;
 
+/*
+ * Behavior states. The numeric values index the constant tables below.
+ * LCL2 and LCR2 change two lanes in one maneuver.
+ */
+enum class State : uint8_t { CS = 0, KL, LCL, LCR, PLCL, PLCR, LCL2, LCR2 };
+
+const int NUM_STATES = 8;
+
+// lateral move of each state, in lanes
+constexpr int8_t LANE_DIRECTION[NUM_STATES] = {0, 0, -1, 1, -1, 1, -2, 2};
+
+// most successors any state has, see TRANSITIONS in vehicle.cpp
+const int MAX_SUCCESSORS = 7;
+
+constexpr int lane_direction(State state) { return LANE_DIRECTION[(int) state]; }
+
+const char *state_name(State state);
+
+class PredictionStore;
+class RoadModel;
+
 class Vehicle {
 public:
 
-  map<string, int> lane_direction = {{"LCL", -1}, {"LCR", 1}};
-
   struct collider{
 
     bool collision ; // is there a collision?
@@ -20,11 +42,13 @@ public:
 
   };
 
-  int L = 1;
+  struct decision{
 
-  int preferred_buffer = 6; // impacts "keep lane" behavior.
+    vector<State> states; // successor states that produced a trajectory
+    vector<float> costs; // cost of each of those states
+    int best = -1; // index of the chosen state
 
-  int lane;
+  };
 
   float s;
 
@@ -34,44 +58,43 @@ public:
 
   float d;
 
-  float target_speed;
+  float target_speed=0;
+
+  float max_acceleration=0;
 
-  int lanes_available;
+  float goal_s=0;
 
-  float max_acceleration;
+  int16_t lane;
 
-  int target_lane=0;
+  int16_t target_lane=0;
 
-  int goal_s;
+  int16_t lanes_available=0;
 
-  string state;
+  State state;
+
+  const RoadModel *road_model=nullptr; // lane centers and speed limits, set for the ego by Road
 
   /**
   * Constructor
   */
   Vehicle();
-  Vehicle(int lane, float s,float d, float v_s, float a_s, string state="CS",int target_lane=1);
-
-  /**
-  * Destructor
-  */
-  virtual ~Vehicle();
+  Vehicle(int lane, float s,float d, float v_s, float a_s, State state=State::CS,int target_lane=1);
 
-  vector<Vehicle> choose_next_state(map<int, vector<Vehicle>> predictions,float time_window);
+  frame_vector<Vehicle> choose_next_state(const PredictionStore &predictions,float time_window, decision *log=NULL);
 
-  vector<string> successor_states();
+  frame_vector<State> successor_states();
 
-  vector<Vehicle> generate_trajectory(string state, map<int, vector<Vehicle>> predictions,float time_window);
+  frame_vector<Vehicle> generate_trajectory(State state, const PredictionStore &predictions,float time_window);
 
-  vector<float> get_kinematics(map<int, vector<Vehicle>> predictions, int lane,float time_window);
+  frame_vector<float> get_kinematics(const PredictionStore &predictions, int lane,float time_window);
 
-  vector<Vehicle> constant_speed_trajectory(float time_window);
+  frame_vector<Vehicle> constant_speed_trajectory(float time_window);
 
-  vector<Vehicle> keep_lane_trajectory(map<int, vector<Vehicle>> predictions,float time_window);
+  frame_vector<Vehicle> keep_lane_trajectory(const PredictionStore &predictions,float time_window);
 
-  vector<Vehicle> lane_change_trajectory(string state, map<int, vector<Vehicle>> predictions,float time_window);
+  frame_vector<Vehicle> lane_change_trajectory(State state, const PredictionStore &predictions,float time_window);
 
-  vector<Vehicle> prep_lane_change_trajectory(string state, map<int, vector<Vehicle>> predictions,float time_window);
+  frame_vector<Vehicle> prep_lane_change_trajectory(State state, const PredictionStore &predictions,float time_window);
 
   void s_increment(float dt);
 
@@ -79,16 +102,18 @@ public:
 
   float s_speed_at(float t);
 
-  vector<double> get_vehicle_behind(map<int, vector<Vehicle>> predictions, Vehicle & rVehicle,int lane);
+  frame_vector<double> get_vehicle_behind(const PredictionStore &predictions, Vehicle & rVehicle,int lane);
 
-  vector<double> get_vehicle_ahead(map<int, vector<Vehicle>> predictions, Vehicle & rVehicle,int lane);
+  frame_vector<double> get_vehicle_ahead(const PredictionStore &predictions, Vehicle & rVehicle,int lane);
 
-  vector<Vehicle> generate_predictions(float horizon);
+  void realize_next_state(const frame_vector<Vehicle> &trajectory);
 
-  void realize_next_state(vector<Vehicle> trajectory);
-
-  void configure(vector<float> road_data);
+  // target speed, lanes available, goal s and max acceleration
+  void configure(const float *road_data);
 
 };
 
+// Vehicles are copied into every trajectory and prediction; keep them plain data.
+static_assert(is_trivially_copyable<Vehicle>::value, "Vehicle must stay trivially copyable");
+
 #endif